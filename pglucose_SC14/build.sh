@@ -4,5 +4,11 @@ mkdir binary
 cd code/core/
 make 
 cp pglucose ../../binary/pglucose
+cd ../bench/
+make
+cp parsebench ../../binary/parsebench
+cd prop/
+make
+cp propbench ../../../binary/propbench
 
  
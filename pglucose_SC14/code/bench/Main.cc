@@ -0,0 +1,99 @@
+/*************************************************************************************[bench/Main.cc]
+Micro-benchmark of the DIMACS tokenizers: the sequential StreamBuffer parser against the block
+scanners used on mmapped input (scalar, SSE2 and AVX2 when the CPU supports them).
+
+  USAGE: parsebench <input-file> [rounds]
+**************************************************************************************************/
+
+#include <sys/time.h>
+
+#include "utils/ParseUtils.h"
+#include "core/Dimacs.h"
+
+using namespace Glucose;
+
+//=================================================================================================
+
+
+// Stands for the solver in 'parse_DIMACS_main()': only counts what it is given.
+struct ClauseCounter {
+    int      vars;
+    int      clauses;
+    uint64_t lits;
+
+    ClauseCounter() : vars(0), clauses(0), lits(0) {}
+    int  nVars     () const      { return vars; }
+    Var  newVar    ()            { return vars++; }
+    bool addClause_(vec<Lit>& ps){ clauses++; lits += ps.size(); return true; }
+};
+
+static double wallTime() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000; }
+
+static const char* simd_names[] = { "scalar", "sse2", "avx2" };
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        fprintf(stderr, "USAGE: %s <input-file> [rounds]\n", argv[0]), exit(1);
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+        fprintf(stderr, "ERROR! Could not open file: %s\n", argv[1]), exit(1);
+    size_t      len  = st.st_size;
+    const char* data = (const char*)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED || (len >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b))
+        fprintf(stderr, "ERROR! Expecting an uncompressed file: %s\n", argv[1]), exit(1);
+
+    int         vars    = 0;
+    int         clauses = 0;
+    const char* body    = parse_DIMACS_header(data, data + len, vars, clauses);
+    double      mb      = len / 1048576.0;
+    printf("%s: %d variables, %d clauses, %.1f MB\n", argv[1], vars, clauses, mb);
+
+    // Sequential parser (decompression thread and byte-wise tokenizer):
+    double best = 0;
+    for (int r = 0; r < rounds; r++){
+        ClauseCounter cc;
+        double        t  = wallTime();
+        gzFile        in = gzopen(argv[1], "rb");
+        parse_DIMACS(in, cc);
+        gzclose(in);
+        t = wallTime() - t;
+        if (r == 0 || t < best) best = t;
+        if (r == 0) printf("%-12s: %d clauses, %"PRIu64" literals\n", "StreamBuffer", cc.clauses, cc.lits); }
+    printf("%-12s: %8.3f s  %8.1f MB/s\n", "StreamBuffer", best, mb / best);
+
+    // Block scanners on the whole body, single threaded:
+    int64_t ref = -1;
+    DimacsChunk ch;
+    ch.begin = body;
+    ch.end   = data + len;
+    for (int simd = simd_none; simd <= simdLevel(); simd++){
+        for (int r = 0; r < rounds; r++){
+            ch.lits.clear();          // Keeps the memory, so that only tokenizing is measured.
+            ch.clauses = ch.max_var = 0;
+            double t = wallTime();
+            parse_DIMACS_chunk(ch, simd);
+            t = wallTime() - t;
+            if (r == 0 || t < best) best = t;
+
+            int64_t sum = 0;
+            for (int i = 0; i < ch.lits.size(); i++)
+                sum = sum * 31 + ch.lits[i];
+            if (ref == -1) ref = sum;
+            else if (sum != ref)
+                fprintf(stderr, "ERROR! %s tokenizer disagrees with the scalar one\n", simd_names[simd]), exit(1);
+            if (r == 0) printf("%-12s: %d clauses, %d literals\n", simd_names[simd], ch.clauses, ch.lits.size() - ch.clauses); }
+        printf("%-12s: %8.3f s  %8.1f MB/s\n", simd_names[simd], best, mb / best);
+    }
+
+    munmap((void*)data, len);
+    return 0;
+}
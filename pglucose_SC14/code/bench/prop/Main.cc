@@ -0,0 +1,108 @@
+/*************************************************************************************[bench/prop/Main.cc]
+Micro-benchmark of 'Solver::propagate()': the same random decisions are replayed on each instance,
+with the clause arena in parsing order and then in watch order (after a garbage collection), each
+time without and with the prefetching of the clause headers. Each measure loads the instance again:
+propagation reorders the watch lists, which must not carry over from one measure to the next.
+
+  USAGE: propbench [-rounds=N] [-ahead=N] [-repeat=N] <input-file> ...
+**************************************************************************************************/
+
+#include <sys/time.h>
+
+#include "utils/Options.h"
+#include "utils/ParseUtils.h"
+#include "core/Dimacs.h"
+#include "core/Solver.h"
+
+using namespace Glucose;
+
+//=================================================================================================
+
+
+static IntOption opt_rounds("BENCH", "rounds", "Descents from the top level per measure", 2000, IntRange(1, INT32_MAX));
+static IntOption opt_ahead ("BENCH", "ahead",  "Prefetch distance of the measures with prefetching", 4, IntRange(1, 64));
+static IntOption opt_repeat("BENCH", "repeat", "Measures per configuration (the best one is kept)", 3, IntRange(1, INT32_MAX));
+
+static double wallTime() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1000000; }
+
+
+// Gives access to the propagation engine: each round decides random variables with random signs
+// until a conflict or a complete assignment, then backtracks to the top level.
+struct Replay : public Solver {
+    uint64_t replay(int rounds, double seed){
+        uint64_t props = propagations;
+        for (int r = 0; r < rounds; r++){
+            for (;;){
+                Var v = irand(seed, nVars());
+                for (int k = 0; k < nVars() && value(v) != l_Undef; k++)
+                    v = v + 1 == nVars() ? 0 : v + 1;
+                if (value(v) != l_Undef)
+                    break;
+                newDecisionLevel();
+                uncheckedEnqueue(mkLit(v, drand(seed) < 0.5));
+                if (propagate() != CRef_Undef)
+                    break;
+            }
+            cancelUntil(0);
+        }
+        return propagations - props;
+    }
+};
+
+
+// Load 'file' into 'S' and simplify it; the clauses are relocated in watch order for 'watch'.
+static bool load(Replay& S, const char* file, bool watch){
+    gzFile in = gzopen(file, "rb");
+    if (in == NULL)
+        fprintf(stderr, "ERROR! Could not open file: %s\n", file), exit(1);
+    parse_DIMACS(in, S);
+    gzclose(in);
+    if (!S.simplify())
+        return false;
+    if (watch)
+        S.garbageCollect();
+    return true;
+}
+
+
+static void measure(const char* file, bool watch, int ahead){
+    double   best  = 0;
+    uint64_t props = 0;
+    for (int r = 0; r < opt_repeat; r++){
+        Replay S;
+        load(S, file, watch);
+        S.prefetch = ahead;
+        double t = wallTime();
+        props = S.replay(opt_rounds, 91648253);
+        t = wallTime() - t;
+        if (r == 0 || props / t > best) best = props / t; }
+    printf("  %-6s prefetch %2d: %12"PRIu64" propagations  %12.0f /s\n", watch ? "watch" : "parse", ahead, props, best);
+    fflush(stdout);
+}
+
+
+int main(int argc, char** argv)
+{
+    setUsageHelp("USAGE: %s [options] <input-file> ...\n");
+    parseOptions(argc, argv, true);
+    if (argc < 2)
+        fprintf(stderr, "USAGE: %s [options] <input-file> ...\n", argv[0]), exit(1);
+
+    for (int i = 1; i < argc; i++){
+        Replay S;
+        bool   ok = load(S, argv[i], false);
+        printf("%s: %d variables, %d clauses\n", argv[i], S.nVars(), S.nClauses());
+        if (!ok){
+            printf("  unsatisfiable at the top level\n");
+            continue; }
+
+        measure(argv[i], false, 0);
+        measure(argv[i], false, opt_ahead);
+        measure(argv[i], true,  0);
+        measure(argv[i], true,  opt_ahead);
+    }
+    return 0;
+}
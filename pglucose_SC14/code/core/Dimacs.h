@@ -22,6 +22,13 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #define Glucose_Dimacs_h
 
 #include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "utils/ParseUtils.h"
 #include "core/SolverTypes.h"
@@ -83,6 +90,215 @@ static void parse_DIMACS(gzFile input_stream, Solver& S) {
     StreamBuffer in(input_stream);
     parse_DIMACS_main(in, S); }
 
+//=================================================================================================
+// Parallel DIMACS Parser for uncompressed files:
+//
+// The file is mmapped and its body is split into one chunk per thread, at '0' clause terminators.
+// Each chunk is tokenized on its own thread into a flat literal buffer, then the chunks are added
+// to the solver in file order, so the resulting clause database is the same as with the sequential
+// parser.
+
+static const int dimacs_min_chunk = 1048576;
+
+struct DimacsChunk {
+    const char* begin;
+    const char* end;
+    vec<int>    lits;          // Parsed literals, each clause being terminated by 0.
+    int         max_var;
+    int         clauses;
+    int         simd;          // Block scanner used to tokenize the chunk (see 'simdLevel()').
+    pthread_t   thread;
+
+    DimacsChunk() : begin(NULL), end(NULL), max_var(0), clauses(0), simd(simd_none) {}
+};
+
+// Tokenizes a chunk. With a block scanner, all the complete tokens of the next 'width' bytes are
+// located at once from the digit/whitespace/minus masks; comments, unexpected characters and the
+// last bytes of the chunk go through the byte-wise path.
+template<class Scan>
+static void parse_DIMACS_chunk(DimacsChunk& ch) {
+    const char* p         = ch.begin;
+    const char* end       = ch.end;
+    bool        in_clause = false;
+    for (;;){
+        while (Scan::width > 1 && p + Scan::width <= end){
+            unsigned digits = Scan::digits(p);
+            unsigned minus  = Scan::minus(p);
+            unsigned tok    = digits | minus;
+            unsigned starts = tok & ~(tok << 1);
+            unsigned ends   = tok & ~(tok >> 1);
+            unsigned bad    = (~(tok | Scan::spaces(p)) & Scan::full()) | (minus & ~starts);
+
+            // Tokens must end before 'limit': the last one may go on in the next block.
+            int limit = bad ? __builtin_ctz(bad) : (int)Scan::width;
+            if ((tok >> (Scan::width - 1)) && limit > Scan::width - 1) limit = Scan::width - 1;
+
+            const char* next = p + limit;
+            for (; starts; starts &= starts - 1, ends &= ends - 1){
+                int a = __builtin_ctz(starts), b = __builtin_ctz(ends);
+                if (b >= limit) { if (a < limit) next = p + a; break; }
+                const char* q   = p + a;
+                bool        neg = *q == '-';
+                if (neg && ++q > p + b) { next = p + a; break; }
+                int         val = 0;
+                for (; q <= p + b; q++)
+                    val = val*10 + (*q - '0');
+                if (val > ch.max_var) ch.max_var = val;
+                ch.lits.push(neg ? -val : val);
+                in_clause = val != 0;
+                if (!in_clause) ch.clauses++;
+            }
+            if (next == p) break;
+            p = next;
+        }
+
+        p = scanWhitespace<ScalarScan>(p, end);
+        if (p == end) break;
+        else if (*p == 'c' && !in_clause){
+            p = (const char*)memchr(p, '\n', end - p);
+            if (p == NULL) break;
+        }else{
+            int parsed_lit = scanInt<ScalarScan>(p, end);
+            ch.lits.push(parsed_lit);
+            if (abs(parsed_lit) > ch.max_var) ch.max_var = abs(parsed_lit);
+            in_clause = parsed_lit != 0;
+            if (!in_clause) ch.clauses++; }
+    }
+    if (in_clause)
+        fprintf(stderr, "PARSE ERROR! Unexpected end of file in a clause\n"), exit(3);
+}
+
+#if defined(__x86_64__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+static void parse_DIMACS_chunk_avx2(DimacsChunk& ch) { parse_DIMACS_chunk<AVX2Scan>(ch); }
+#pragma GCC pop_options
+#endif
+
+static void parse_DIMACS_chunk(DimacsChunk& ch, int simd) {
+    switch (simd){
+#if defined(__x86_64__)
+    case simd_avx2: parse_DIMACS_chunk_avx2(ch);         break;
+    case simd_sse2: parse_DIMACS_chunk<SSE2Scan>(ch);    break;
+#endif
+    default:        parse_DIMACS_chunk<ScalarScan>(ch);  break; }
+}
+
+static void* parse_DIMACS_thread(void* arg) {
+    DimacsChunk& ch = *(DimacsChunk*)arg;
+    parse_DIMACS_chunk(ch, ch.simd);
+    return NULL;
+}
+
+// Returns the position just after the first '0' token at or after 'p' which is not part of a
+// comment line, or 'end' if there is none.
+static const char* next_DIMACS_clause_end(const char* begin, const char* p, const char* end) {
+    for (; p < end; p++){
+        if (*p != '0' || (p > begin && !isspace((unsigned char)p[-1])) || (p+1 < end && !isspace((unsigned char)p[1])))
+            continue;
+        const char* q = p;
+        while (q > begin && q[-1] != '\n') q--;
+        while (q < p && isspace((unsigned char)*q)) q++;
+        if (*q == 'c'){
+            while (p < end && *p != '\n') p++;
+            continue; }
+        return p + 1;
+    }
+    return end;
+}
+
+// Reads the comments and the "p cnf" line at the beginning of [begin, end), returns the start of the
+// clauses.
+static const char* parse_DIMACS_header(const char* begin, const char* end, int& vars, int& clauses) {
+    MemBuffer in(begin, end);
+    for (;;){
+        skipWhitespace(in);
+        if (*in == 'c')
+            skipLine(in);
+        else if (*in == 'p'){
+            if (eagerMatch(in, "p cnf")){
+                vars    = parseInt(in);
+                clauses = parseInt(in);
+            }else{
+                printf("PARSE ERROR! Unexpected char: %c\n", *in), exit(3);
+            }
+        }else
+            break;
+    }
+    return in.position();
+}
+
+// Inserts problem into solver. Returns false, leaving the solver untouched, if the file can not be
+// mapped or is compressed; the caller should then fall back to the gzFile version.
+//
+template<class Solver>
+static bool parse_DIMACS(const char* file, Solver& S, int nthreads) {
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 2){
+        close(fd);
+        return false; }
+
+    size_t      len  = st.st_size;
+    const char* data = (const char*)mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    if ((unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b){
+        munmap((void*)data, len);
+        return false; }
+    madvise((void*)data, len, MADV_WILLNEED);
+
+    const char* end     = data + len;
+    int         vars    = 0;
+    int         clauses = 0;
+    const char* body    = parse_DIMACS_header(data, end, vars, clauses);
+
+    int         nchunks = (int)((end - body) / dimacs_min_chunk);
+    if (nchunks > nthreads) nchunks = nthreads;
+    if (nchunks < 1)        nchunks = 1;
+
+    DimacsChunk* chunks = new DimacsChunk[nchunks];
+    int          simd   = simdLevel();
+    for (int i = 0; i < nchunks; i++){
+        chunks[i].simd  = simd;
+        chunks[i].begin = i == 0 ? body : chunks[i-1].end;
+        chunks[i].end   = i == nchunks-1 ? end
+                        : next_DIMACS_clause_end(body, body + (end - body) / nchunks * (i+1), end);
+        if (chunks[i].end < chunks[i].begin) chunks[i].end = chunks[i].begin;
+    }
+    for (int i = 1; i < nchunks; i++)
+        pthread_create(&chunks[i].thread, NULL, parse_DIMACS_thread, &chunks[i]);
+    parse_DIMACS_chunk(chunks[0], simd);
+
+    // Merge in order, while the following chunks are still being parsed:
+    vec<Lit> lits;
+    int      cnt = 0;
+    for (int i = 0; i < nchunks; i++){
+        DimacsChunk& ch = chunks[i];
+        if (i > 0) pthread_join(ch.thread, NULL);
+        while (ch.max_var > S.nVars()) S.newVar();
+        for (int j = 0; j < ch.lits.size(); j++){
+            int parsed_lit = ch.lits[j];
+            if (parsed_lit == 0){
+                S.addClause_(lits);
+                lits.clear();
+            }else
+                lits.push( (parsed_lit > 0) ? mkLit(parsed_lit-1) : ~mkLit(-parsed_lit-1) );
+        }
+        cnt += ch.clauses;
+        ch.lits.clear(true);
+    }
+    delete [] chunks;
+    munmap((void*)data, len);
+
+    if (vars != S.nVars())
+        fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of variables.\n");
+    if (cnt  != clauses)
+        fprintf(stderr, "WARNING! DIMACS header mismatch: wrong number of clauses.\n");
+    return true;
+}
+
 //=================================================================================================
 }
 
@@ -122,6 +122,8 @@ int main(int argc, char** argv)
 			     INT32_MAX, IntRange(0, INT32_MAX));
         IntOption    mem_lim("MAIN", "mem-lim","Limit on memory usage in megabytes.\n", INT32_MAX, 
 			     IntRange(0, INT32_MAX));
+        StringOption cache  ("MAIN", "cache", "Binary cache of the problem: loaded instead of parsing the input file when it is\n"
+                              "        up to date with it, (re)written from the input file otherwise.\n");
 
 	//Options to treat parallelism 
 	IntOption    threads("MULTITHREADING", "threads", "Number of workers.\n", 
@@ -134,6 +136,32 @@ int main(int argc, char** argv)
 	IntOption    maxsizeshared("MULTITHREADING", "msh", "The maximum size for a shared learned clause.\n", 
 				   2, IntRange(0, INT32_MAX));
 
+	IntOption    sharelits("MULTITHREADING", "share-lits", 
+			       "Literals exported per second by each worker, the -msh LBD bound and a size bound being adapted to it (0=fixed -msh).\n", 
+			       0, IntRange(0, INT32_MAX));
+
+	IntOption    importfilter("MULTITHREADING", "import-filter", 
+				  "Filter of the imported clauses (0=none, 1=duplicates, 2=also satisfied or subsumed by a binary).\n", 
+				  1, IntRange(0, 2));
+
+	IntOption    split("MULTITHREADING", "split", 
+			   "Choice of the split variables of the cubes (0=vsids, 1=lookahead on the most active variables).\n", 
+			   0, IntRange(0, 1));
+
+	IntOption    splitcands("MULTITHREADING", "split-cands", 
+				"Number of variables probed by the lookahead split.\n", 
+				16, IntRange(1, INT32_MAX));
+
+	BoolOption   pin("MULTITHREADING", "pin", 
+			 "Bind each worker thread to its own cpu, a NUMA node being filled before the next one.\n"
+			 "The memory of the workers is only placed on their node with -pin.\n", false);
+
+	BoolOption   shareorig("MULTITHREADING", "share-orig", 
+			       "Keep a single read-only copy of the original clauses for all workers.\n", false);
+
+	BoolOption   count("MULTITHREADING", "count", 
+			   "Count the models (#SAT) instead of finding one.\n", false);
+
         parseOptions(argc, argv, true);
      	threads++;
 	
@@ -153,7 +181,13 @@ int main(int argc, char** argv)
 	  ps->setSdb(&sharedBase);
 	  ps->setSqueue(&shared);
 	  ps->setMsshared(maxsizeshared);
+	  ps->setShareLits(sharelits);
+	  ps->setImportFilter(importfilter);
+	  ps->setSplit(split, splitcands);
+	  ps->setShareOrig(shareorig);
 	}
+	pSolver::setPinning(pin);
+	pSolver::setCounting(count);
 
 	pSolver& S = *data[0];
         double initial_time = cpuTime();
@@ -182,17 +216,25 @@ int main(int argc, char** argv)
         if (argc == 1)
             printf("c Reading from standard input... Use '--help' for help.\n");
 
-	/* Parsing the cnf for each thread */
-	for (int i=0; i<threads; i++) {
-	  gzFile in = (argc == 1) ? gzdopen(0, "rb") : gzopen(argv[1], "rb");
-	  if (in == NULL)
-            printf("c ERROR! Could not open file: %s\n", argc == 1 ? "<stdin>" : argv[1]), exit(1);
+	/* Loading the problem once, then replicate it for each thread.
+	   An up to date binary cache is mapped as is, plain files are mmapped
+	   and parsed in parallel, the others go through zlib */
+	bool cached = cache && argc > 1 && S.fromBinary(cache, argv[1]);
+	if (!cached){
+	  if (argc == 1 || !parse_DIMACS(argv[1], S, threads)){
+	    gzFile in = (argc == 1) ? gzdopen(0, "rb") : gzopen(argv[1], "rb");
+	    if (in == NULL)
+	      printf("c ERROR! Could not open file: %s\n", argc == 1 ? "<stdin>" : argv[1]), exit(1);
 	  
-	  parse_DIMACS(in,  *data[i]);
-
-	  gzclose(in);
+	    parse_DIMACS(in, S);
+	    gzclose(in);
+	  }
+	  if (cache && (argc == 1 || !S.toBinary(cache, argv[1])))
+	    printf("c WARNING! Could not write the cache file: %s\n", (const char*)cache);
 	}
 
+	pSolver::replicate(threads, data);
+
 	if (verb > 0){
 	  printf("c ========================================[ Problem Statistics ]===========================================\n");
 	  printf("c |                                                                                                       |\n"); 
@@ -201,7 +243,9 @@ int main(int argc, char** argv)
         
         if (S.verbosity > 0){
             printf("c |  Number of variables:  %12d                                                                   |\n", S.nVars());
-            printf("c |  Number of clauses:    %12d                                                                   |\n", S.nClauses()); }
+            printf("c |  Number of clauses:    %12d                                                                   |\n", S.nClauses());
+            if (cached)
+            printf("c |  Loaded from the binary cache                                                                         |\n"); }
         
         double parsed_time = cpuTime();
         if (S.verbosity > 0){
@@ -233,12 +277,18 @@ int main(int argc, char** argv)
 	    printf("c ========================================================================================================\n");
 	  }
 	
-	mpz_t p;
-	mpz_init(p);
-	shared.getResult(p);
+	if (S.verbosity > 0 && shared.getResult() != l_Undef)
+	  printf("c Result found by thread %d\n", shared.getWinner());
 	
-	if (mpz_cmp_ui(p, 1)==0 ||
-	    mpz_cmp_ui(p, 1)>0){
+	if (count){
+	  mpz_t n;
+	  mpz_init(n);
+	  shared.getCount(n);
+	  printf(mpz_sgn(n) > 0 ? "s SATISFIABLE\n" : "s UNSATISFIABLE\n");
+	  gmp_printf("c s exact arb int %Zd\n", n);
+	  mpz_clear(n);
+	}
+	else if (shared.getResult() == l_True){
 	  
 	  printf("v ");
 	  for (int i = 0; i < data[0]->nVars(); i++)
@@ -252,7 +302,6 @@ int main(int argc, char** argv)
 	  printf("s UNSATISFIABLE\n");
 	
 
-	mpz_clear(p);
 	for (int i=0; i<threads; i++) 
 	  delete data[i];
 	
@@ -0,0 +1,79 @@
+#include "core/ParallelSolver.h"
+
+using namespace Glucose;
+
+ParallelSolver::ParallelSolver(int workers, int height_) :
+    threads    (workers+1)
+  , height     (height_)
+  , shared     (workers+1, height_, 1<<height_)
+  , sharedBase (workers+1)
+  , data       (new pSolver*[workers+1])
+  , ok         (true)
+{
+  for (int i=0; i<threads; i++){
+    data[i] = new pSolver();
+    data[i]->setId(i);
+    data[i]->setSdb(&sharedBase);
+    data[i]->setSqueue(&shared);
+    data[i]->setMsshared(2);
+  }
+  data[0]->setKeepPool(true);
+}
+
+ParallelSolver::~ParallelSolver(){
+  data[0]->releasePool();
+  for (int i=0; i<threads; i++)
+    delete data[i];
+  delete[] data;
+}
+
+Var ParallelSolver::newVar(bool polarity, bool dvar){
+  for (int i=1; i<threads; i++)
+    data[i]->newVar(polarity, dvar);
+  return data[0]->newVar(polarity, dvar);
+}
+
+//The workers are idle between two calls, possibly
+//left on the trail of their last search. The clauses
+//of data[0] must not grow once shared read-only with
+//the workers (setShareOrig): they are refused then.
+bool ParallelSolver::addClause(const vec<Lit>& ps){
+  for (int i=0; i<threads; i++)
+    if (data[i]->shareorig)
+      return false;
+  for (int i=0; i<threads; i++){
+    data[i]->cancelUntil(0);
+    if (!data[i]->addClause(ps))
+      ok = false;
+  }
+  return ok;
+}
+
+bool ParallelSolver::solve(const vec<Lit>& assumps){
+  model.clear();
+  conflict.clear();
+  if (!ok) return false;
+
+  for (int i=0; i<threads; i++)
+    data[i]->setAssumptions(assumps);
+  data[0]->solveMultiThreaded(height, threads, data);
+
+  lbool ret = shared.getResult();
+  if (ret == l_True){
+    data[0]->model.copyTo(model);
+    return true;
+  }
+
+  //No assumption in the final conflict, or a solver inconsistent
+  //at the top level: the clauses are UNSAT. Without a result
+  //(interrupted), the next call starts again
+  if (ret == l_False){
+    data[shared.getWinner()]->conflict.copyTo(conflict);
+    if (conflict.size() == 0)
+      ok = false;
+  }
+  for (int i=0; i<threads; i++)
+    if (!data[i]->okay())
+      ok = false;
+  return false;
+}
@@ -0,0 +1,50 @@
+#ifndef Glucose_ParallelSolver_h
+#define Glucose_ParallelSolver_h
+
+#include "core/pSolver.h"
+#include "core/SharedJob.h"
+#include "core/SharedBase.h"
+
+namespace Glucose {
+
+  // Incremental interface of the parallel solver: the worker
+  // threads, their learnt clauses and the shared lists are kept
+  // from a call to solve() to the next one. The clauses and the
+  // variables are added to all the solvers. The pool of workers
+  // being static, one ParallelSolver may exist at a time.
+  // Sharing the original clauses (setShareOrig) is not supported:
+  // addClause() refuses any clause then, without changing okay().
+  class ParallelSolver {
+  public:
+    ParallelSolver(int workers, int height = 1);
+    ~ParallelSolver();
+
+    Var  newVar    (bool polarity = true, bool dvar = true);
+    bool addClause (const vec<Lit>& ps);
+    bool solve     (const vec<Lit>& assumps);
+    bool solve     ()  { vec<Lit> none; return solve(none); }
+
+    bool okay      () const { return ok; }
+    int  nVars     () const { return data[0]->nVars(); }
+    int  nClauses  () const { return data[0]->nClauses(); }
+
+    // Solver i, 0 being the coordinator, to set its options
+    pSolver& getSolver(int i) { return *data[i]; }
+
+    // Extra results: (read-only member variable)
+    //
+    vec<lbool> model;     // If problem is satisfiable, this vector contains the model (if any).
+    vec<Lit>   conflict;  // If problem is unsatisfiable (possibly under assumptions),
+                          // this vector represent the final conflict clause expressed in the assumptions.
+
+  private:
+    int         threads;  // workers + the coordinator
+    int         height;
+    Shared      shared;
+    SharedBase  sharedBase;
+    pSolver   **data;
+    bool        ok;
+  };
+}
+
+#endif
@@ -1,19 +1,24 @@
 #include "core/SharedBase.h"
 #include <iostream>
+#include <string.h>
 
 using namespace Glucose;
 
 SharedBase::SharedBase(int threads_) : 
   threads (threads_){
-  Lists = new ListLearn[threads_];
+  rings = new Ring[threads_];
+  readers = new Reader[threads_];
   for(int i=0; i<threads_; i++ ) {
-    Lists[i].head = 0;
-    Lists[i].tail = 0;
-    Lists[i].sidx = new SelfishIdx[threads];
-    Lists[i].rmfrqc = 0;
-    Lists[i].nba = 0;
-    Lists[i].nbs = 0;
-    Lists[i].nbptr=0;
+    rings[i].buf = NULL;
+    rings[i].reserved = 0;
+    rings[i].head = 0;
+    rings[i].seq = 0;
+    rings[i].nba = 0;
+    rings[i].nbo = 0;
+    rings[i].used = 0;
+    readers[i].cursor = NULL;
+    readers[i].seq = NULL;
+    readers[i].dropped = 0;
   }
 
   /*RAJOUT STAGE*/
@@ -26,74 +31,58 @@ SharedBase::SharedBase(int threads_) :
 SharedBase::~SharedBase()  {
 
   for(int i=0; i<threads; i++){
- 
-    elearn *cur = Lists[i].head;
-
-    while(cur != 0){
-      elearn *nxt= cur->next;
-      delete cur; 
-      cur=nxt;
-    }
-    
-    delete[] Lists[i].sidx;
+    delete[] rings[i].buf;
+    delete[] readers[i].cursor;
+    delete[] readers[i].seq;
   }
 
-  delete[] Lists;
-}
-
-// List Primitive 
-void SharedBase::append(elearn *e, ListLearn *l)
-{ 
-  if (l->tail) 
-    l->tail->next = e;
-  else 
-    l->head = e;
-  l->tail = e;
+  delete[] rings;
+  delete[] readers;
 }
 
-/*
-tete de la liste de partage
-suppr toutes les clauses déjà partagées entre tous les autres threads.
-*/
-void SharedBase::clean(ListLearn *l) {
-  
-  elearn *cur = l->head;
- 
-  if (!cur) return;
-
-  while(cur != 0 && cur->cref == 0){
-    elearn *nxt= cur->next;
-    delete cur;
-    l->nbs++;
-    cur=nxt;
-  }
-
-  if(!cur)
-    l->tail=0;
-
-  l->head = cur;
+//A ring is read once its head moved, after 'buf' was set
+void SharedBase::attach(int i) {
+  if (rings[i].buf != NULL)
+    return;
+  rings[i].buf = new uint32_t[ring_size];
+  memset(rings[i].buf, 0, sizeof(uint32_t)*ring_size);
+  readers[i].cursor = new uint64_t[threads];
+  readers[i].seq = new uint32_t[threads];
+  memset(readers[i].cursor, 0, sizeof(uint64_t)*threads);
+  memset(readers[i].seq, 0, sizeof(uint32_t)*threads);
+  __sync_synchronize();
 }
 
-
-
 /*
 sharedBase->push(learnt_clause, nblevels,this);
 Solveur->id indique la file où rajouter le nouveau élément. 
 
-
+The record is first reserved, then written, then published: a reader
+that finds 'reserved' past its copy + ring_size knows it was overwritten.
 */
 void SharedBase::push(vec<Lit>& learn, int nblev, pSolver *solver) {
 
-  ListLearn &l = Lists[solver->id];
-  elearn *e = new elearn(learn,nblev,threads-2);
-  append(e, &l);
-  l.nba++;  
+  Ring &r = rings[solver->id];
+  uint32_t len = learn.size() + 3;
+  r.nba++;
+  if (len > ring_size){
+    r.nbo++;
+    return;
+  }
+
+  uint64_t h = r.head;
+  r.reserved = h + len;
+  __sync_synchronize();
 
-  /* the reduce of the DB */
-  if(solver->conflicts >=
-     (uint64_t)solver->curRestart* 
-     solver->nbclausesbeforereduce)
-    clean(&Lists[solver->id]);
+  uint32_t mask = ring_size - 1;
+  r.buf[h & mask] = r.seq++;
+  r.buf[(h+1) & mask] = nblev;
+  r.buf[(h+2) & mask] = learn.size();
+  for (int k=0; k<learn.size(); k++)
+    r.buf[(h+3+k) & mask] = toInt(learn[k]);
+
+  __sync_synchronize();
+  r.head = h + len;
 }
 
 
@@ -102,75 +91,54 @@ void SharedBase::update(pSolver * solver)
 {
   //S'identifier
   int id = solver->id;
-  elearn* j,*nxt;
+  Reader& rd = readers[id];
 
+  //The records of all the other rings are gathered in rd.tmp
+  //and imported as a single batch
+  rd.tmp.clear();
   for (int i=1; i<threads; i++) {
     //Ne pas gerer sa propre base de données.
     if (id == i)
        continue;
       
-    //Se positionner sur une des Bases de Données partagés
-    ListLearn& l = Lists[i];
-
-    //Si le pointeur d'une des listes pointe sur NULL, le reposoitionner à "head"
-    if (!l.sidx[id].ptr) 
-      j= l.sidx[id].ptr = l.head;
-    else {
-      //Le faire avancer d'un cran sinon (donc, possibilité de ponter sur NULL ici je suppose, d'où le precedent if)
-      j = l.sidx[id].ptr->next;
-      //si pointe sur du non vide, soustraire atomiquement 1 à l'indice de référence de la case précédente.
-      if(j)
-	__sync_sub_and_fetch(&(l.sidx[id].ptr->cref),1);
+    Ring& r = rings[i];
+    uint64_t& cur = rd.cursor[i];
+    uint64_t h = r.head;
+    __sync_synchronize();
+    if (cur == h)
+      continue;
+    //Lapped: the records from 'cur' are being overwritten
+    if (r.reserved > cur + ring_size){
+      cur = h;
+      continue;
     }
 
-    //j est une elearn, donc possède un ensemble de littéraux (= UNE CLAUSE), un nb de niveaux (?), pointeur sur suivant, et une référence vers ...
-    while(j) { 
-      //Tant que j ne pointe pas vers NULL, pas vide
-      //se placer sur le vecteur des littéraux de j
-      vec<Lit>& learn = j->learn;
-
-      //S'il ne reste plus qu'un littéral, alors
-      if (learn.size() == 1){
-        //si valeur == 2, donc non défini, donc si tous les deux sont indéfinis à la base (normalement?)...les indéfinis appartiennent à NOUS
-        //pas à la clause/littéral partagée.
-	if (solver->value(learn[0]) == l_Undef)
-	  solver->uncheckedEnqueue(learn[0]);
-    //Prend en queue d'attente un littéral => enregistrer son signe (vrai/faux), enregistrer son niveau + sa raison, l'enregistrer dans trail.
-    //On enregistre le littéral restnt qui est affecté chez le thread voisin, mais pas chez nous.
-      }
-      else {
-      // S'il y a plusieurs littéraux, donc la clause partagée n'est pas unitaire, c'est là qu'on la gèle eventuellement!
-      // Pour chaque nouvelle clause, si geler on la doit, on le fait.
-	CRef cr = solver->ca.alloc(learn, true);
-	solver->ca[cr].setLBD(j->nblevels); 
-	solver->learnts.push(cr);
-	solver->attachClause(cr);
-	solver->claBumpActivity(solver->ca[cr]);
-
-  /*RAJOUT STAGE*/
-
-  // Indique si oui ou non, on doit geler la clause nouvellement apprise.
-  // 
-
-  solver->frozen_clauses.push(solver->mkFreeze(0, solver->to_freeze(cr)));
-  //solver->frozen_clauses.push(solver->to_freeze(cr));
-
-  /*FIN RAJOUT STAGE*/
+    //Copy [cur, h) then check that none of it was overwritten meanwhile
+    uint32_t n = h - cur;
+    uint32_t s = cur & (ring_size - 1);
+    uint32_t first = n < ring_size - s ? n : ring_size - s;
+    int base = rd.tmp.size();
+    rd.tmp.growTo(base + n);
+    uint32_t *t = (uint32_t*)rd.tmp + base;
+    memcpy(t, r.buf + s, sizeof(uint32_t)*first);
+    memcpy(t + first, r.buf, sizeof(uint32_t)*(n - first));
+    __sync_synchronize();
+    bool lapped = r.reserved > cur + ring_size;
+    cur = h;
+    if (lapped){
+      rd.tmp.shrink(n);
+      continue;
+    }
 
-      } 
-      solver->varDecayActivity();
-      solver->claDecayActivity();
-      
-      //Avancer au litteral suivant.
-      l.sidx[id].ptr = j;
-      nxt=j->next;
+    //Records missing since the last one read have been overwritten.
+    //The seq word is then replaced by the producer for importLearnts
+    for (uint32_t k=0; k<n; k+=3+t[k+2]) {
+      if (t[k] != rd.seq[i])
+	rd.dropped += t[k] - rd.seq[i];
+      rd.seq[i] = t[k] + 1;
+      t[k] = i;
+    }
+  }
 
-    //Si nxt != NULL, s'il reste des littéraux, soustraire atomiquement 1 à l'indice de référence de la case précédente (j).  
-      if(nxt) 
-	__sync_sub_and_fetch(&(j->cref),1);
-      
-      j=nxt;     
-      
-   }	
- } 
+  solver->importLearnts((uint32_t*)rd.tmp, rd.tmp.size());
 }
@@ -19,33 +19,30 @@ namespace Glucose {
 
   class SharedBase {
   private:
-    struct elearn;    
-    struct elearn {
-      vec<Lit>    learn;
-      int nblevels;
-      int cref;
-      elearn *next;
-        
-      elearn(vec<Lit>& l,int nbl,int th) : 
-	nblevels(nbl),cref(th),next (0) { 
-	l.copyTo(learn);	 
-      }
+    //Each producer owns a ring of 'ring_size' words where its
+    //shared learnts are stored inline, as [seq, nblevels, size, lits].
+    //Only the owner writes to it, readers copy from their own cursor.
+    //The owner never waits: the oldest records are overwritten, and a
+    //reader that was lapped skips them (counted in Reader::dropped).
+    static const uint32_t ring_size = 1 << 20;
+
+    struct Ring {
+      uint32_t          *buf;
+      volatile uint64_t reserved;   //end of the record being written
+      volatile uint64_t head;       //end of the last complete record
+      uint32_t          seq;        //number of records written
+      int nba;                      //clauses pushed
+      int nbo;                      //clauses larger than the ring
+      volatile int used;            //imports of its clauses used in a conflict
+      char pad[64];
     };
 
-    struct SelfishIdx{
-      elearn* ptr;
-      SelfishIdx(): ptr (0) {}
-       
-    };
-
-    struct ListLearn{
-      elearn *head;
-      elearn *tail;
-      SelfishIdx* sidx;
-      int rmfrqc;
-      int nba;
-      int nbs;
-      int nbptr;
+    struct Reader {
+      uint64_t      *cursor;        //per ring: next word to read
+      uint32_t      *seq;           //per ring: next record expected
+      vec<uint32_t> tmp;
+      int dropped;                  //overwritten before being read
+      char pad[64];
     };
 
     /*RAJOUT STAGE*/
@@ -57,12 +54,8 @@ namespace Glucose {
 
     //Attributs
     int threads;
-    ListLearn *Lists;
-
-    // Primitive for List
-    void append(elearn *e, ListLearn *l);
-    void clean(ListLearn *l);    
-    //void tryCleanDB(Solver *solver);
+    Ring   *rings;
+    Reader *readers;
 
   public:
     SharedBase(int threads);
@@ -71,9 +64,14 @@ namespace Glucose {
     //Main interface
     void push(vec<Lit>& learn, int nbl,pSolver *solver);
     void update(pSolver *solver);
-    int getTotalDB(int i) const { return Lists[i].nba ;}
-    int getTotalSDB(int i) const { return Lists[i].nbs ;}
-    int getNbPtr(int i) const { return Lists[i].nbptr ;}
+    //Allocate the ring and the reader of worker 'i' from its
+    //own thread, so that they are first touched on its node
+    void attach(int i);
+    int getTotalDB(int i) const { return rings[i].nba ;}
+    int getDropped(int i) const { return readers[i].dropped ;}
+    int getOversized(int i) const { return rings[i].nbo ;}
+    int getUsed(int i) const { return rings[i].used ;}
+    void used(int i) { __sync_fetch_and_add(&rings[i].used, 1); }
 
   };
   
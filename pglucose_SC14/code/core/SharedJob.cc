@@ -1,222 +1,270 @@
 #include "core/SharedJob.h"
 #include <cstdio>
 #include <unistd.h>
+#include <math.h>
+#include <errno.h>
+#include "utils/System.h"
 
 using namespace Glucose;
-void _clean_(void *arg) {
-  pthread_mutex_unlock((pthread_mutex_t*)arg); 
-}
 
 Shared::Shared(int threads_, int height_): 
-    jobs           (new Job[1])
-  , newjid         (0)
-  , size           (1)
-  , first          (0)
-  , last           (0)
-  , waiting        (0)
+    newjid         (0)
+  , jobs_left      (0)
+  , idle           (0)
+  , sleeping       (0)
+  , split_req      (0)
+  , next_owner     (0)
+  , status         (0)
   , threads        (threads_)
   , height         (height_)
   , end            (false)
+  , events         (0)
   , tids             (new pthread_t[threads_-1])
   
 {
   pthread_mutex_init(&mutex, 0);
   pthread_cond_init(&cond, 0);
-  mpz_init(result);
-  mpz_set_ui(result, 0);
+  pthread_cond_init(&done, 0);
+  mpz_init(count);
+  mpz_set_ui(count, 0);
+  alloc(1);
 }
 
 Shared::Shared(int threads_, int height_, unsigned int size_): 
-    jobs           (new Job[size_])
-  , newjid         (0)
-  , size           (size_)
-  , first          (0)
-  , last           (0)
-  , waiting        (0)
+    newjid         (0)
+  , jobs_left      (0)
+  , idle           (0)
+  , sleeping       (0)
+  , split_req      (0)
+  , next_owner     (0)
+  , status         (0)
   , threads        (threads_)
   , height         (height_)
   , end            (false)
+  , events         (0)
   , tids             (new pthread_t[threads_-1]) {
   pthread_mutex_init(&mutex, 0);
   pthread_cond_init(&cond, 0);
-  mpz_init(result);
-  mpz_set_ui(result, 0);
+  pthread_cond_init(&done, 0);
+  mpz_init(count);
+  mpz_set_ui(count, 0);
+  alloc(size_);
 }
   
 Shared::~Shared(){
-  delete[] jobs;
+  release();
   delete[] tids;
   pthread_mutex_destroy(&mutex);
   pthread_cond_destroy(&cond);
-  mpz_clear(result);
+  pthread_cond_destroy(&done);
+  mpz_clear(count);
+}
+
+//The 'size_' jobs expected are shared among the deques
+void Shared::alloc(unsigned int size_){
+  int workers = threads > 1 ? threads-1 : 1;
+  unsigned int s = size_ / workers + 2;
+  deques = new Deque[workers];
+  for (int i=0; i<workers; i++){
+    deques[i].jobs = new Job[s];
+    deques[i].size = s;
+    deques[i].first = 0;
+    deques[i].last = 0;
+    pthread_mutex_init(&deques[i].lock, 0);
+  }
+  seeds = new uint32_t[threads];
+  for (int i=0; i<threads; i++)
+    seeds[i] = 2654435761u * (i+1);
 }
 
+void Shared::release(){
+  int workers = threads > 1 ? threads-1 : 1;
+  for (int i=0; i<workers; i++){
+    delete[] deques[i].jobs;
+    pthread_mutex_destroy(&deques[i].lock);
+  }
+  delete[] deques;
+  delete[] seeds;
+}
+
+//Called by the coordinator while no worker runs.
+//The result is kept: a global restart must not
+//lose the one posted while stopping the workers
 void Shared::init(int threads_, 
 		  int height_, 
 		  unsigned int size_){
 
-  delete[] jobs;
-  pthread_mutex_init(&mutex, 0);
-  pthread_cond_init(&cond, 0);
-  mpz_set_ui(result, 0);
-  jobs=new Job[size_];
-  newjid =  0;
-  size =size_;
-  first = 0;
-  last  = 0;
-  waiting  = 0;
+  release();
+  mpz_set_ui(count, 0);
   threads = threads_;
   height = height_;
+  alloc(size_);
+  newjid =  0;
+  jobs_left = 0;
+  idle = 0;
+  sleeping = 0;
+  split_req = 0;
+  next_owner = 0;
   end  = false;
 }
 
-void Shared::push(vec<TYPE>& in) {
-  pthread_cleanup_push(_clean_, &mutex);
-  pthread_mutex_lock(&mutex);
+void Shared::push(const vec<TYPE>& in, int owner){
+  if (owner == 0)
+    owner = 1 + next_owner++ % (threads-1);
+  Deque& d = deques[owner-1];
 
-  if ((last+1) % size == first) {
-    Job* tmp = new Job[size * SIZE_FACTOR];
-    for(unsigned int i = 0; i < size; i++) {
-      tmp[i] = jobs[(first+i)%size];
-    }
-    first = 0;
-    last = size-1;
-    size *= SIZE_FACTOR;
-    delete[] jobs;
-    jobs = tmp;
+  pthread_mutex_lock(&d.lock);
+  if ((d.last+1) % d.size == d.first) {
+    Job* jobs = new Job[d.size * SIZE_FACTOR];
+    for(unsigned int i = 0; i < d.size; i++)
+      jobs[i] = d.jobs[(d.first+i)%d.size];
+    d.first = 0;
+    d.last = d.size-1;
+    d.size *= SIZE_FACTOR;
+    delete[] d.jobs;
+    d.jobs = jobs;
   }
-  jobs[last].jid = newjid++;
-  in.copyTo(jobs[last].assumps);
-  last = (last+1) % size;
-  pthread_cond_signal(&cond);
+  d.jobs[d.last].fid = owner;
+  d.jobs[d.last].jid = __sync_fetch_and_add(&newjid, 1);
+  d.jobs[d.last].offset = d.arena.size();
+  d.jobs[d.last].size = in.size();
+  for (int i=0; i<in.size(); i++)
+    d.arena.push(in[i]);
+  d.last = (d.last+1) % d.size;
+  pthread_mutex_unlock(&d.lock);
 
-  pthread_mutex_unlock(&mutex);
-  pthread_cleanup_pop(0);
+  //Wake up the idle workers, if any
+  __sync_fetch_and_add(&jobs_left, 1);
+  if (sleeping > 0){
+    pthread_mutex_lock(&mutex);
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+  }
 }
 
-void Shared::push(vec<TYPE>& in, int fid){
-  pthread_cleanup_push(_clean_, &mutex);
-  pthread_mutex_lock(&mutex);
-
-  if ((last+1) % size == first) {
-    Job* tmp = new Job[size * SIZE_FACTOR];
-    for(unsigned int i = 0; i < size; i++) {
-      tmp[i] = jobs[(first+i)%size];
+//Take the newest job of 'd' (bottom) or its oldest one
+bool Shared::take(Deque& d, vec<TYPE>& out, bool bottom){
+  pthread_mutex_lock(&d.lock);
+  bool ret = d.first != d.last;
+  if (ret){
+    Job j;
+    if (bottom){
+      d.last = (d.last + d.size - 1) % d.size;
+      j = d.jobs[d.last];
+    }else{
+      j = d.jobs[d.first];
+      d.first = (d.first+1) % d.size;
     }
-    first = 0;
-    last = size-1;
-    size *= SIZE_FACTOR;
-    delete[] jobs;
-    jobs = tmp;
+    out.clear();
+    for (uint32_t i=0; i<j.size; i++)
+      out.push(d.arena[j.offset+i]);
+    //The arena is freed from the top, or all at once
+    if (d.first == d.last)
+      d.arena.clear();
+    else if (j.offset + j.size == (uint32_t)d.arena.size())
+      d.arena.shrink(j.size);
   }
-  jobs[last].fid = fid;
-  jobs[last].jid = newjid++;
-  in.copyTo(jobs[last].assumps);
-  last = (last+1) % size;
-  pthread_cond_signal(&cond);
-
-  pthread_mutex_unlock(&mutex);
-  pthread_cleanup_pop(0);
+  pthread_mutex_unlock(&d.lock);
+  if (ret)
+    __sync_fetch_and_sub(&jobs_left, 1);
+  return ret;
 }
 
-
 void Shared::endAll(){
+  pthread_mutex_lock(&mutex);
   end =true;
   pthread_cond_broadcast(&cond);
- 
-  for (int i=0; i<threads-1; i++)
-    if( pthread_self() != tids[i])
-      pthread_cancel(tids[i]);
-}
-
-bool Shared::pop(vec<TYPE>& out) {
-  bool ret = false;
- 
-  pthread_mutex_lock(&mutex);
-  pthread_cleanup_push(_clean_, &mutex);
-  
-  //Detect the end of the solving: no more subproblem
-  //and no thread is working  
-  if (first == last && waiting == threads-1) {
-     end = true;
-    pthread_cond_broadcast(&cond);
-  }
-  
-  //Wait for a new subproblem: at least 
-  //one thread was working.
-  while (!end && first == last) {
-    waiting++;
-    pthread_cond_wait(&cond, &mutex);
-    waiting--;
-  }
-
-  //Pick a subproblem
-  if(first != last) {
-    jobs[first].assumps.copyTo(out);
-    first = (first+1) % size;
-    ret = true;
-  }
- 
-
- 
-  pthread_cleanup_pop(0);
   pthread_mutex_unlock(&mutex);
-  return ret;
 }
 
-bool Shared::pop(Job& out){
-
-  bool ret = false;
+bool Shared::pop(vec<TYPE>& out, int worker) {
+  if (take(deques[worker-1], out, true))
+    return true;
 
- 
-  pthread_mutex_lock(&mutex);
-  pthread_cleanup_push(_clean_, &mutex);
-
-  if (first == last && waiting == threads-1) {
-    end = true;
-    pthread_cond_broadcast(&cond);
-  }
-
-  while (!end && first == last) {
-    waiting++;
-    pthread_cond_wait(&cond, &mutex);
-    waiting--;
-  }
+  __sync_fetch_and_add(&idle, 1);
+  while (!end) {
+    //Steal from the victims in turn, starting from a random
+    //one. The worker is not idle meanwhile, so that the end
+    //is not detected while it holds a job.
+    if (jobs_left > 0) {
+      __sync_fetch_and_sub(&idle, 1);
+      int workers = threads-1;
+      uint32_t& s = seeds[worker];
+      s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+      for (int k=0; k<workers; k++) {
+	int v = (s + k) % workers;
+	if (take(deques[v], out, v == worker-1))
+	  return true;
+      }
+      __sync_fetch_and_add(&idle, 1);
+      continue;
+    }
 
-  if(first != last) {
-    out = jobs[first];
-    first = (first+1) % size;
-    ret = true;
+    pthread_mutex_lock(&mutex);
+    __sync_fetch_and_add(&sleeping, 1);
+    //Detect the end of the solving: no more subproblem
+    //and no worker is busy (only busy workers push)
+    if (idle == threads-1 && jobs_left == 0) {
+      end = true;
+      pthread_cond_broadcast(&cond);
+    }else
+      //Ask the busy workers for a part of their cube
+      split_req = 1;
+    while (!end && jobs_left <= 0)
+      pthread_cond_wait(&cond, &mutex);
+    __sync_fetch_and_sub(&sleeping, 1);
+    pthread_mutex_unlock(&mutex);
   }
+  return false;
+}
 
-  pthread_cleanup_pop(0);
-  pthread_mutex_unlock(&mutex);
+bool Shared::takeSplitRequest() {
+  return split_req && jobs_left == 0 && idle > 0 &&
+    __sync_bool_compare_and_swap(&split_req, 1, 0);
+}
 
-  return ret;
+bool Shared::putResult(lbool res, int worker) {
+  int s = ((worker+1) << 2) | toInt(res);
+  if (!__sync_bool_compare_and_swap(&status, 0, s))
+    return false;
+  notify();
+  return true;
 }
 
-void Shared::putResult(mpz_t r) {
-  
+void Shared::addCount(mpz_t c) {
   pthread_mutex_lock(&mutex);
-  pthread_cleanup_push(_clean_, &mutex);
-  mpz_add(result,result,r);
-  pthread_cleanup_pop(0);
+  mpz_add(count, count, c);
   pthread_mutex_unlock(&mutex);
-
 }
 
-void Shared::getResult(mpz_t& out) {
-  mpz_set(out, result);
+void Shared::notify() {
+  pthread_mutex_lock(&mutex);
+  events++;
+  pthread_cond_broadcast(&done);
+  pthread_mutex_unlock(&mutex);
 }
 
+bool Shared::waitEvent(unsigned int& seen, double deadline) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)deadline;
+  ts.tv_nsec = (long)((deadline - floor(deadline)) * 1e9);
 
-void Shared::IFinish() {
- 
   pthread_mutex_lock(&mutex);
-  pthread_cleanup_push(_clean_, &mutex);
-  waiting++;
-  pthread_cleanup_pop(0);
+  while (events == seen) {
+    if (deadline == 0)
+      pthread_cond_wait(&done, &mutex);
+    else if (realTime() >= deadline ||
+	     pthread_cond_timedwait(&done, &mutex, &ts) == ETIMEDOUT)
+      break;
+  }
+  bool ret = events != seen;
+  seen = events;
   pthread_mutex_unlock(&mutex);
+  return ret;
+}
 
-
+void Shared::getCount(mpz_t& out) {
+  pthread_mutex_lock(&mutex);
+  mpz_set(out, count);
+  pthread_mutex_unlock(&mutex);
 }
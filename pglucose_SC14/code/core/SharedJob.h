@@ -12,78 +12,110 @@
 
 namespace Glucose {
 
-  //This is the class that represents 
-  //a subproblem : the vector assumps 
-  //stores a partial assignment
+  //This is the class that represents
+  //a subproblem : a cube of decisions,
+  //stored in the arena of its deque
   class Job {
   public:
-    vec<TYPE> assumps;
+    uint32_t offset;   //first decision in the arena
+    uint32_t size;     //number of decisions
     int jid;
     int fid;
-    Job& operator=(const Job& j) {
-      fid = j.fid;
-      jid = j.jid;
-      j.assumps.copyTo(assumps);
-	return *this;
-    }  
   };
-  
-  // This class represents 
-  // the shared queue of subproblems
-  // to be resolved
+
+  // This class represents the subproblems
+  // to be resolved: each worker owns a deque,
+  // pushes and pops its own subproblems at
+  // the bottom and, when it is empty, steals
+  // the oldest one of a random victim.
   class Shared {
   private:
-    Job            *jobs;
-    unsigned int    newjid;
-    unsigned int    size;
-    unsigned int    first;
-    unsigned int    last;
-    mpz_t           result;
-    
-    int             waiting;
+    struct Deque {
+      Job             *jobs;
+      unsigned int     size;
+      unsigned int     first;     //oldest job, taken by thieves
+      unsigned int     last;      //after the newest job, taken by the owner
+      vec<TYPE>        arena;     //decisions of the jobs, reset when empty
+      pthread_mutex_t  lock;
+      char pad[64];
+    };
+
+    Deque          *deques;       //one per worker 1..threads-1
+    volatile int    newjid;
+    volatile int    jobs_left;    //jobs in all the deques
+    volatile int    idle;         //workers without a job
+    volatile int    sleeping;     //idle workers blocked on 'cond'
+    volatile int    split_req;    //raised by a worker going to sleep
+    unsigned int    next_owner;   //round robin for the jobs of the coordinator
+    uint32_t       *seeds;        //per worker, to pick victims
+
+    //Result of the solving, set once by the first worker reporting
+    //it: toInt() of its lbool in the low bits, 1+its id above (0: none)
+    volatile int    status;
+    mpz_t           count;        //models counted by the workers (#SAT)
+
     int             threads;
     int             height;
-    
+
     // Synchro variables
     pthread_mutex_t mutex;
     pthread_cond_t  cond;
-    bool            end;
+    volatile bool   end;
+
+    // Wakes up the coordinator: 'events' is bumped
+    // by every result and notification
+    pthread_cond_t  done;
+    unsigned int    events;
+
+    void alloc(unsigned int size_);
+    void release();
+    bool take(Deque& d, vec<TYPE>& out, bool bottom);
 
   public:
     pthread_t      *tids;
 
     //Constructor:
     Shared(int threads_, int height_);
-    Shared(int threads_, int height_, 
+    Shared(int threads_, int height_,
 	   unsigned int sizein);
-    void init(int threads_, 
-	      int height_, 
+    void init(int threads_,
+	      int height_,
 	      unsigned int size_);
     ~Shared();
-    
-    //Old Interface:
-    void push(vec<TYPE>& in);
-    //Returns 1 if success to pop, 
-    //otherwise 0 queue is empty
-    bool pop(vec<TYPE>& out);
-  
-    void push(vec<TYPE>& in, int fid);
-    bool pop(Job& j);
-
-    void putResult(mpz_t r);
-
-    void IFinish();
-    
+
+    //Push the cube 'in' on the deque of worker 'owner',
+    //those of the coordinator (0) are spread over all deques
+    void push(const vec<TYPE>& in, int owner);
+    //Returns 1 if success to pop, otherwise 0: all
+    //the workers are idle and no job is left, or endAll()
+    bool pop(vec<TYPE>& out, int worker);
+    //True for the single busy worker that must serve the
+    //split request of an idle worker, if no job is left
+    bool takeSplitRequest();
+
+    //Report l_True or l_False, ignored once a result is known:
+    //false is returned then
+    bool putResult(lbool res, int worker);
+    //Forget the result, before a new solve only
+    void clearResult() { status = 0; }
+    void addCount(mpz_t c);
+
+    //Wake up the coordinator to check its conditions
+    void notify();
+    //Wait until an event newer than 'seen' or the
+    //realTime() 'deadline' (0: none); false on timeout
+    bool waitEvent(unsigned int& seen, double deadline);
+
     //Accessors:
-    void getResult(mpz_t& out);
-    int getJobLeft() const  {
-      if(last >= first) return  last - first;
-      else return size - first + last;
-    }
+    lbool getResult() const { return status ? toLbool(status & 3) : l_Undef; }
+    int getWinner() const { return (status >> 2) - 1; }
+    void getCount(mpz_t& out);
+    int getJobLeft() const  { return jobs_left; }
     int getHeight() const { return height; }
     int getThreads() const { return threads; }
     int getNbJobs() const { return newjid; }
 
+    //Wake up the workers waiting for a job: pop() fails
     void endAll();
   };
 }
@@ -28,6 +28,12 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 **************************************************************************************************/
 
 #include <math.h>
+#include <limits.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "mtl/Sort.h"
 #include "core/Solver.h"
@@ -72,6 +78,7 @@ static IntOption     opt_restart_first     (_cat, "rfirst",      "The base resta
 static DoubleOption  opt_restart_inc       (_cat, "rinc",        "Restart interval increase factor", 2, DoubleRange(1, false, HUGE_VAL, false));
 */
 static DoubleOption  opt_garbage_frac      (_cat, "gc-frac",     "The fraction of wasted memory allowed before a garbage collection is triggered",  0.20, DoubleRange(0, false, HUGE_VAL, false));
+static IntOption     opt_prefetch          (_cat, "prefetch",    "Prefetch the clause headers of the watchers this far ahead in propagation (0=off)", 0, IntRange(0, 64));
 
 
 //=================================================================================================
@@ -102,6 +109,7 @@ Solver::Solver() :
   , rnd_pol          (false)
   , rnd_init_act     (opt_rnd_init_act)
   , garbage_frac     (opt_garbage_frac)
+  , prefetch         (opt_prefetch)
 
 
     // Statistics: (formerly in 'SolverStats')
@@ -115,24 +123,29 @@ Solver::Solver() :
   , cla_inc            (1)
   , var_inc            (1)
   , watches            (WatcherDeleted(ca))
-  , watchesBin            (WatcherDeleted(ca))
+  , watchesTer         (TerWatcherDeleted(ca))
+  , implied            (ImpliedDeleted())
   , qhead              (0)
   , simpDB_assigns     (-1)
   , simpDB_props       (0)
   , order_heap         (VarOrderLt(activity))
   , progress_estimate  (0)
   , remove_satisfied   (true)
+  , binary_map         (NULL)
+  , binary_len         (0)
 
     // Resource constraints:
     //
   , conflict_budget    (-1)
   , propagation_budget (-1)
   , asynch_interrupt   (false)
-{MYFLAG=0;}
+{MYFLAG=0; bin_conflict[0] = bin_conflict[1] = lit_Undef;}
 
 
 Solver::~Solver()
 {
+    if (binary_map != NULL)
+        munmap(binary_map, binary_len);
 }
 
 
@@ -148,8 +161,10 @@ Var Solver::newVar(bool sign, bool dvar)
     int v = nVars();
     watches  .init(mkLit(v, false));
     watches  .init(mkLit(v, true ));
-    watchesBin  .init(mkLit(v, false));
-    watchesBin  .init(mkLit(v, true ));
+    watchesTer.init(mkLit(v, false));
+    watchesTer.init(mkLit(v, true ));
+    implied  .init(mkLit(v, false));
+    implied  .init(mkLit(v, true ));
     assigns  .push(l_Undef);
     vardata  .push(mkVarData(CRef_Undef, 0));
     //activity .push(0);
@@ -184,7 +199,9 @@ bool Solver::addClause_(vec<Lit>& ps)
     else if (ps.size() == 1){
         uncheckedEnqueue(ps[0]);
         return ok = (propagate() == CRef_Undef);
-    }else{
+    }else if (ps.size() == 2 && hasBinary(ps[0], ps[1]))
+        return true;
+    else{
         CRef cr = ca.alloc(ps, false);
         clauses.push(cr);
         attachClause(cr);
@@ -194,6 +211,71 @@ bool Solver::addClause_(vec<Lit>& ps)
 }
 
 
+// The clause arena is copied as a whole, so the CRefs stored in 'clauses', the watcher lists and
+// the reasons of the top-level assignments remain valid in this solver.
+//
+// When 'share' is set, the arena of 'from' is not copied but used as the read-only shared region
+// of 'ca'; only the watched literals of the clauses are made private to this solver.
+//
+void Solver::copyProblem(const Solver& from, bool share)
+{
+    assert(decisionLevel() == 0 && from.decisionLevel() == 0);
+    assert(nVars() == 0 && nClauses() == 0);
+
+    if (share){
+        ca.setShared(&from.ca);
+        for (int i = 0; i < from.clauses.size(); i++){
+            const Clause& c = ca[from.clauses[i]];
+            if (c.size() > 3){
+                shared_watches.push();
+                shared_watches.last().lit[0] = c[0];
+                shared_watches.last().lit[1] = c[1];
+            }
+        }
+    }else
+        from.ca.copyTo(ca);
+    from.clauses   .copyTo(clauses);
+    from.watches   .copyTo(watches);
+    from.watchesTer.copyTo(watchesTer);
+    from.implied   .copyTo(implied);
+
+    from.assigns   .copyTo(assigns);
+    from.vardata   .copyTo(vardata);
+    from.seen      .copyTo(seen);
+    from.permDiff  .copyTo(permDiff);
+    from.polarity  .copyTo(polarity);
+    from.decision  .copyTo(decision);
+    from.trail     .copyTo(trail);
+    trail.capacity(nVars());
+
+    // The initial activities are drawn by each solver, as 'newVar()' does (see 'rnd_init_act'),
+    // so that the solvers do not all start from the order of 'from':
+    activity.capacity(nVars());
+    for (Var v = 0; v < nVars(); v++){
+        activity.push(rnd_init_act ? drand(random_seed) * 0.00001 : 0);
+        insertVarOrder(v); }
+
+    ok               = from.ok;
+    qhead            = from.qhead;
+    var_inc          = from.var_inc;
+    dec_vars         = from.dec_vars;
+    clauses_literals = from.clauses_literals;
+}
+
+
+// Number the clauses of size > 3 in the order of 'clauses' (the order 'copyProblem()' uses to
+// build the 'shared_watches' of the other solvers). The clauses must have the extra field, and
+// this solver must not remove or move them anymore: 'ca' is lent, and refuses to change.
+//
+void Solver::shareClauses()
+{
+    assert(ca.extra_clause_field && !remove_satisfied);
+    ca.lend();
+    uint32_t idx = 0;
+    for (int i = 0; i < clauses.size(); i++)
+        if (ca[clauses[i]].size() > 3)
+            ca[clauses[i]].setSharedIndex(idx++);
+}
 
 
 /*RAJOUT STAGE*/
@@ -262,7 +344,7 @@ bool Solver::to_freeze(CRef cr){
 void Solver::freeze_analyse(){
   bool before, after;
   int i, j;
-  for(i = 0 ; i < learnts.size(); i++){
+  for(i = j = 0 ; i < learnts.size(); i++){
     before = frozen_clauses[i].freeze;
     // analyser la clause, attribuer une valeur a la clause actuelle
     after = frozen_clauses[i].freeze = to_freeze(learnts[i]);
@@ -298,6 +380,7 @@ void Solver::freeze_analyse(){
       
   }
   learnts.shrink(i-j);
+  frozen_clauses.shrink(i-j);
   checkGarbage();
 }
 
@@ -335,10 +418,14 @@ void Solver::attachClause(CRef cr) {
     // inverse de la polarité de littéral 1 et 2 de la clause.
     //
     if(c.size()==2) {
-      // Créer watcher avec le littéral n°2 et le n° de la clause enregistrée.
-      // faira ajouter au tableau watchesBin avec comme indice la valeur du littéral avec sa polaritée opposée.
-      watchesBin[~c[0]].push(Watcher(cr, c[1]));
-      watchesBin[~c[1]].push(Watcher(cr, c[0]));
+      // Clause binaire : chaque littéral faux implique l'autre.
+      implied[~c[0]].push(c[1]);
+      implied[~c[1]].push(c[0]);
+    } else if(c.size()==3) {
+      // Clause ternaire : surveillée par ses trois littéraux, sans watch à déplacer.
+      watchesTer[~c[0]].push(TerWatcher(cr, c[1], c[2]));
+      watchesTer[~c[1]].push(TerWatcher(cr, c[0], c[2]));
+      watchesTer[~c[2]].push(TerWatcher(cr, c[0], c[1]));
     } else {
       // Si clause non binaire, alors :
       //
@@ -353,18 +440,47 @@ void Solver::attachClause(CRef cr) {
 
 
 
+// Remove the implication 'q' from 'imps', if 'cleanImplied()' has not already done it. A binary
+// clause is only attached once (see 'hasBinary()'), so no other clause holds the same entry.
+static void removeImplied(vec<Lit>& imps, Lit q) {
+    for (int i = 0; i < imps.size(); i++)
+        if (imps[i] == q){
+            imps[i] = imps.last();
+            imps.pop();
+            return; }
+}
+
+
+// The shorter of the two implication lists of the clause is searched.
+bool Solver::hasBinary(Lit p, Lit q) {
+    if (implied[~p].size() > implied[~q].size()){
+        Lit t = p; p = q; q = t; }
+    const vec<Lit>& imps = implied[~p];
+    for (int i = 0; i < imps.size(); i++)
+        if (imps[i] == q)
+            return true;
+    return false;
+}
+
+
 void Solver::detachClause(CRef cr, bool strict) {
     const Clause& c = ca[cr];
     
     assert(c.size() > 1);
+    assert(!ca.isShared(cr));
     if(c.size()==2) {
+      // Always strict: the implications do not refer to the clause, which may be freed right away
+      removeImplied(implied[~c[0]], c[1]);
+      removeImplied(implied[~c[1]], c[0]);
+    } else if(c.size()==3) {
       if (strict){
-        remove(watchesBin[~c[0]], Watcher(cr, c[1]));
-        remove(watchesBin[~c[1]], Watcher(cr, c[0]));
+        remove(watchesTer[~c[0]], TerWatcher(cr, c[1], c[2]));
+        remove(watchesTer[~c[1]], TerWatcher(cr, c[0], c[2]));
+        remove(watchesTer[~c[2]], TerWatcher(cr, c[0], c[1]));
       }else{
-        // Lazy detaching: (NOTE! Must clean all watcher lists before garbage collecting this clause)
-        watchesBin.smudge(~c[0]);
-        watchesBin.smudge(~c[1]);
+        watchesTer.smudge(~c[0]);
+        watchesTer.smudge(~c[1]);
+        watchesTer.smudge(~c[2]);
       }
     } else {
       if (strict){
@@ -387,8 +503,10 @@ void Solver::removeClause(CRef cr) {
   
   Clause& c = ca[cr];
   detachClause(cr);
-  // Don't leave pointers to free'd memory!
-  if (locked(c)) vardata[var(c[0])].reason = CRef_Undef;
+  // Don't leave pointers to free'd memory! (a ternary clause may imply any of its literals)
+  if (locked(c))
+    for (int i = 0; i < (c.size() == 3 ? 3 : 1); i++)
+      if (!isBinReason(var(c[i])) && reason(var(c[i])) == cr) vardata[var(c[i])].reason = CRef_Undef;
   c.mark(1); 
   ca.free(cr);
 }
@@ -485,29 +603,42 @@ void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel,unsigned
 
     do{
         assert(confl != CRef_Undef); // (otherwise should be UIP)
-        Clause& c = ca[confl];
-
-	// Special case for binary clauses
-	// The first one has to be SAT
-
-  // Si la clause est binaire, le litéral est défini et si l'inverse de la polarité du 1er littéral est faux? 
-	if( p != lit_Undef && c.size()==2 && value(c[0])==l_False) {
-	  
-	  assert(value(c[1])==l_True);
-    //Euh...
-	  Lit tmp = c[0];
-	  c[0] =  c[1], c[1] = tmp;
-	}
+        Lit        bin[2];
+        const Lit* lits;
+        int        first, size;
+        bool       any_order = false;
+
+        if (p == lit_Undef ? confl == CRef_BinConflict : isBinReason(var(p))){
+            // Binary clause: 'bin_conflict' for the conflict, else 'p' and the literal implying it.
+            bin[0] = p == lit_Undef ? bin_conflict[0] : p;
+            bin[1] = p == lit_Undef ? bin_conflict[1] : binReasonLit(var(p));
+            lits   = bin;
+            first  = p == lit_Undef ? 0 : 1;
+            size   = 2;
+        }else{
+            Clause& c = ca[confl];
+            any_order = unordered(confl, c);
 
 	     // Si la clause fait partie des clauses apprises?
        // Increase a clause with the current 'bump' value.
-       if (c.learnt())
+       if (c.learnt()){
             claBumpActivity(c);
+	    if (c.source()){
+	      importUsed(c.source() - 1);
+	      c.setSource(0);
+	    }
+       }
+            lits  = &c[0];
+            first = p == lit_Undef || any_order ? 0 : 1;
+            size  = c.size();
+        }
 
         // pour chaque littéral de la clause sauf eventuellement le 1er
         // 
-        for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
-            Lit q = c[j];
+        // Shared and ternary clauses are not reordered: the implied literal 'p' may be anywhere.
+        for (int j = first; j < size; j++){
+            Lit q = lits[j];
+            if (any_order && q == p) continue;
 
             if (!seen[var(q)] && level(var(q)) > 0){
                 varBumpActivity(var(q));
@@ -516,7 +647,7 @@ void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel,unsigned
                     pathC++;
 #ifdef UPDATEVARACTIVITY
 		    // UPDATEVARACTIVITY trick (see competition'09 companion paper)
-		    if((reason(var(q))!= CRef_Undef)  && ca[reason(var(q))].learnt()) 
+		    if((reason(var(q))!= CRef_Undef) && !isBinReason(var(q)) && ca[reason(var(q))].learnt()) 
 		      lastDecisionLevel.push(q);
 #endif
 
@@ -555,9 +686,13 @@ void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel,unsigned
 
             if (reason(x) == CRef_Undef)
                 out_learnt[j++] = out_learnt[i];
-            else{
+            else if (isBinReason(x)){
+                Lit q = binReasonLit(x);
+                if (!seen[var(q)] && level(var(q)) > 0)
+                    out_learnt[j++] = out_learnt[i];
+            }else{
                 Clause& c = ca[reason(var(out_learnt[i]))];
-                for (int k = 1; k < c.size(); k++)
+                for (int k = unordered(reason(x), c) ? 0 : 1; k < c.size(); k++)
                     if (!seen[var(c[k])] && level(var(c[k])) > 0){
                         out_learnt[j++] = out_learnt[i];
                         break; }
@@ -598,16 +733,16 @@ void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel,unsigned
 	permDiff[var(out_learnt[i])] = MYFLAG;
       }
 
-      vec<Watcher>&  wbin  = watchesBin[p];
+      vec<Lit>&  imps  = implied[p];
       int nb = 0;
-      for(int k = 0;k<wbin.size();k++) {
-	Lit imp = wbin[k].blocker;
+      for(int k = 0;k<imps.size();k++) {
+	Lit imp = imps[k];
 	if(permDiff[var(imp)]==MYFLAG && value(imp)==l_True) {
 	  /*      printf("---\n");
 		  printClause(out_learnt);
 		  printf("\n");
 		  
-		  printClause(*(wbin[k].clause));printf("\n");
+		  printLit(imp);printf("\n");
 	  */
 	  nb++;
 	  permDiff[var(imp)]= MYFLAG-1;
@@ -693,15 +828,24 @@ bool Solver::litRedundant(Lit p, uint32_t abstract_levels)
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
         assert(reason(var(analyze_stack.last())) != CRef_Undef);
-        Clause& c = ca[reason(var(analyze_stack.last()))]; analyze_stack.pop();
-	if(c.size()==2 && value(c[0])==l_False) {
-	  assert(value(c[1])==l_True);
-	  Lit tmp = c[0];
-	  c[0] =  c[1], c[1] = tmp;
-	}
+        Var        x = var(analyze_stack.last());
+        CRef       r = reason(x); analyze_stack.pop();
+        bool       any_order = false;
+        Lit        q;
+        const Lit* lits;
+        int        size;
+        if (isBinReason(x)){
+            q = binReasonLit(x);
+            lits = &q, size = 1;
+        }else{
+            Clause& c = ca[r];
+            any_order = unordered(r, c);
+            lits = any_order ? &c[0] : &c[1], size = any_order ? c.size() : c.size() - 1;
+        }
 
-        for (int i = 1; i < c.size(); i++){
-            Lit p  = c[i];
+        for (int i = 0; i < size; i++){
+            Lit p  = lits[i];
+            if (any_order && var(p) == x) continue;
             if (!seen[var(p)] && level(var(p)) > 0){
                 if (reason(var(p)) != CRef_Undef && (abstractLevel(var(p)) & abstract_levels) != 0){
                     seen[var(p)] = 1;
@@ -746,12 +890,13 @@ void Solver::analyzeFinal(Lit p, vec<Lit>& out_conflict)
             if (reason(x) == CRef_Undef){
                 assert(level(x) > 0);
                 out_conflict.push(~trail[i]);
+            }else if (isBinReason(x)){
+                Lit q = binReasonLit(x);
+                if (level(var(q)) > 0)
+                    seen[var(q)] = 1;
             }else{
                 Clause& c = ca[reason(x)];
-		//                for (int j = 1; j < c.size(); j++) Minisat (glucose 2.0) loop 
-		// Bug in case of assumptions due to special data structures for Binary.
-		// Many thanks to Sam Bayless (sbayless@cs.ubc.ca) for discover this bug.
-		for (int j = ((c.size()==2) ? 0:1); j < c.size(); j++)
+		for (int j = (unordered(reason(x), c) ? 0:1); j < c.size(); j++)
                     if (level(var(c[j])) > 0)
                         seen[var(c[j])] = 1;
             }  
@@ -776,6 +921,15 @@ void Solver::uncheckedEnqueue(Lit p, CRef from)
 }
 
 
+void Solver::uncheckedEnqueueBin(Lit p, Lit q)
+{
+    assert(value(p) == l_Undef && value(q) == l_False);
+    assigns[var(p)] = lbool(!sign(p));
+    vardata[var(p)] = mkBinVarData(q, decisionLevel());
+    trail.push_(p);
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  propagate : [void]  ->  [Clause*]
@@ -791,49 +945,57 @@ CRef Solver::propagate()
 {
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
-    watches.cleanAll();
-    watchesBin.cleanAll();
     // Chef de file d'attente (comme indice dans la piste - pas plus explicite file d'attente de propagation dans MiniSat).
     // Tant que qhead, qui est un indice entier, n'a pas atteint la taille du nombre de variables affectés.
     while (qhead < trail.size()){
         // Se positionner sur le dernier littéral affecté, vu par le qhead.
         Lit            p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
         // Liste des clauses qui surveillent le littéral.
-        vec<Watcher>&  ws  = watches[p];
+        // The lists are cleaned lazily, when their literal is propagated (see 'relocAll()' for the rest):
+        vec<Watcher>&  ws  = watches.lookup(p);
         Watcher        *i, *j, *end;
         num_props++;
 
 	
-	// First, Propagate binary clauses 
-  // Liste des clauses binaires qui surveillent le littéral?
-	vec<Watcher>&  wbin  = watchesBin[p];
-
-	// Pour toute clause binaire surveillant le littéral
-  // ICI et au début de for suivant: vérifier si la clause est gelée, alors continue?
-  // Ou alors détacher la clause des variables?
-	for(int k = 0 ; k < wbin.size() ; k++) {
-	  // Euh...un des 2 littéraux surveillés par la clause?
-	  Lit imp = wbin[k].blocker;
-	  
-    // Si polarité == 1 ET la variable vaut VRAI (fausse, donc multipolaire?)...retourner la clause 
-    // en tant que clause de conflit, car si var = vrai, alors negation = faux, donc faux...??!
-    // Question : qu'est ce qui nous empeche de dire que l'autre = vrai?? 
-    // La clause est unitaire là! La logique de Watch Literal justement? Affaire à suiiiivre.
+	// First, Propagate binary clauses: the clause is (~p | imp), with ~p as the reason of 'imp'
+	vec<Lit>&  imps  = implied[p];
+	for(int k = 0 ; k < imps.size() ; k++) {
+	  Lit imp = imps[k];
 	  if(value(imp) == l_False) {
-	    return wbin[k].cref;
+	    bin_conflict[0] = ~p;
+	    bin_conflict[1] = imp;
+	    return CRef_BinConflict;
 	  }
+	  if(value(imp) == l_Undef)
+	    uncheckedEnqueueBin(imp, ~p);
+	}
 
-	  // Si pas de valeur attribué par attends, le faire.
-	  if(value(imp) == l_Undef) {
-	    //printLit(p);printf(" ");printClause(wbin[k].cref);printf("->  ");printLit(imp);printf("\n");
-	    uncheckedEnqueue(imp,wbin[k].cref);
+	// Then the ternary clauses (~p | a | b), decided on the literals kept in the watcher
+	vec<TerWatcher>&  wter  = watchesTer.lookup(p);
+	for(int k = 0 ; k < wter.size() ; k++) {
+	  lbool va = value(wter[k].other[0]), vb = value(wter[k].other[1]);
+	  if(va == l_True || vb == l_True) continue;
+	  if(va == l_False && vb == l_False) {
+	    confl = wter[k].cref;
+	    qhead = trail.size();
+	    break;
 	  }
+	  if(va == l_False && vb == l_Undef)
+	    uncheckedEnqueue(wter[k].other[1], wter[k].cref);
+	  else if(vb == l_False && va == l_Undef)
+	    uncheckedEnqueue(wter[k].other[0], wter[k].cref);
 	}
+	if(confl != CRef_Undef)
+	  break;
     
 
 
         // Sinon, pour toute clause non binaire surveillant un littéral.
         for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+            // Request the clauses to inspect next while this one is handled:
+            if (prefetch && end - i > prefetch && value(i[prefetch].blocker) != l_True)
+                __builtin_prefetch(ca.lea(i[prefetch].cref));
+
             // Try to avoid inspecting the clause:
             // Essayez d'éviter l'inspection de la clause:
             Lit blocker = i->blocker;
@@ -841,10 +1003,44 @@ CRef Solver::propagate()
             if (value(blocker) == l_True){
                 *j++ = *i++; continue; }
 
-            // Make sure the false literal is data[1]:
             CRef     cr        = i->cref;
             Clause&  c         = ca[cr];
             Lit      false_lit = ~p;
+
+            // Shared (read-only) clause: same scheme, on the private copy of its watches.
+            if (ca.isShared(cr)){
+                ClauseWatch& cw = shared_watches[c.sharedIndex()];
+                if (cw.lit[0] == false_lit)
+                    cw.lit[0] = cw.lit[1], cw.lit[1] = false_lit;
+                assert(cw.lit[1] == false_lit);
+                i++;
+
+                Lit     first = cw.lit[0];
+                Watcher w     = Watcher(cr, first);
+                if (first != blocker && value(first) == l_True){
+                    *j++ = w; continue; }
+
+                int k;
+                for (k = 0; k < c.size(); k++)
+                    if (c[k] != first && c[k] != false_lit && value(c[k]) != l_False)
+                        break;
+                if (k < c.size()){
+                    cw.lit[1] = c[k];
+                    watches[~c[k]].push(w);
+                    continue; }
+
+                *j++ = w;
+                if (value(first) == l_False){
+                    confl = cr;
+                    qhead = trail.size();
+                    while (i < end)
+                        *j++ = *i++;
+                }else
+                    uncheckedEnqueue(first, cr);
+                continue;
+            }
+
+            // Make sure the false literal is data[1]:
             if (c[0] == false_lit)
                 c[0] = c[1], c[1] = false_lit;
             assert(c[1] == false_lit);
@@ -1017,6 +1213,26 @@ void Solver::removeSatisfied(vec<CRef>& cs)
 }
 
 
+// At level 0, the implications of an assigned literal cannot fire anymore and the true literals
+// need no implication: dropping them first keeps 'removeSatisfied()' from searching long lists.
+void Solver::cleanImplied()
+{
+    assert(decisionLevel() == 0);
+    for (int i = 0; i < 2 * nVars(); i++){
+        Lit       p    = toLit(i);
+        vec<Lit>& imps = implied[p];
+        if (value(p) != l_Undef){
+            imps.clear(true);
+            continue; }
+        int j = 0;
+        for (int k = 0; k < imps.size(); k++)
+            if (value(imps[k]) != l_True)
+                imps[j++] = imps[k];
+        imps.shrink(imps.size() - j);
+    }
+}
+
+
 void Solver::rebuildOrderHeap()
 {
     vec<Var> vs;
@@ -1053,6 +1269,7 @@ bool Solver::simplify()
         return true;
 
     // Remove satisfied clauses:
+    cleanImplied();
     removeSatisfied(learnts);
     // Indique si balayage linéaire éventuellement inefficace pour clauses satisfaites doit être effectuée dans «simplifier».
     if (remove_satisfied)        // Can be turned off.
@@ -1147,7 +1364,8 @@ lbool Solver::search(int nof_conflicts)
                 attachClause(cr);
 
                 claBumpActivity(ca[cr]);
-                uncheckedEnqueue(learnt_clause[0], cr);
+                if (learnt_clause.size() == 2) uncheckedEnqueueBin(learnt_clause[0], learnt_clause[1]);
+                else                           uncheckedEnqueue(learnt_clause[0], cr);
             }
             varDecayActivity();
             claDecayActivity();
@@ -1367,16 +1585,234 @@ void Solver::toDimacs(FILE* f, const vec<Lit>& assumps)
 }
 
 
+//=================================================================================================
+// Binary cache of the problem:
+//
+// A header, the canonical path of the source, the top-level assignments, then the clause arena word
+// for word. Loading finds the clauses again by walking the arena, so there is nothing to parse, and
+// the arena is used in place from a private mapping of the file (pages are only copied when written
+// to). A cache is only loaded for the same source (path, size, modification time and a sample of
+// its content), clause layout and build, and once its arena has been checked.
+
+static const uint32_t binary_magic   = 0x636c6770;     // "pglc"
+static const uint32_t binary_version = 3;              // Bumped with every change of the layout (2: 18-bit
+                                                       // LBD and 8-bit source in 'Clause', 3: source stamp).
+
+enum { binary_extra = 1, binary_unsat = 2, binary_cref64 = 4 };
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;             // binary_extra: the clauses have the extra field, binary_unsat: the problem is
+                                // inconsistent, binary_cref64: written by a 'CREF64' build.
+    uint32_t nvars;
+    uint32_t nunits;            // Number of top-level assignments, stored as 'Lit's.
+    uint32_t arena;             // Size of the clause arena, in words.
+    uint32_t path;              // Length of the canonical path of the source, which follows the header in
+    uint32_t pad;               // 'binaryWords(path)' words.
+    uint64_t source_size;       // Size, modification time (in ns) and sampled content hash of the file the
+    uint64_t source_mtime;      // cache was made from (see 'sourceHash()').
+    uint64_t source_hash;
+};
+
+static uint32_t binaryFlags(const ClauseAllocator& ca, bool ok)
+{
+    uint32_t flags = (ca.extra_clause_field ? binary_extra : 0) | (ok ? 0 : binary_unsat);
+#ifdef CREF64
+    flags |= binary_cref64;
+#endif
+    return flags;
+}
+
+static uint32_t binaryWords(uint32_t bytes) { return (bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t); }
+
+// 64-bit hash of 'len' bytes, in four independent lanes of words:
+static uint64_t hashBytes(const unsigned char* p, uint64_t len)
+{
+    const uint64_t m    = 0x9e3779b97f4a7c15ULL;
+    uint64_t       h[4] = { len, len ^ m, len + m, ~len };
+    uint64_t       i    = 0;
+    for (; i + 32 <= len; i += 32)
+        for (int k = 0; k < 4; k++){
+            uint64_t w;
+            memcpy(&w, p + i + 8 * k, sizeof(w));
+            h[k]  = (h[k] ^ w) * m;
+            h[k] ^= h[k] >> 31; }
+    uint64_t r = h[0];
+    for (int k = 1; k < 4; k++) { r = (r ^ h[k]) * m; r ^= r >> 31; }
+    for (; i < len; i++)        { r = (r ^ p[i]) * m; r ^= r >> 31; }
+    return r;
+}
+
+// The canonical path, the size and the modification time of the file a cache is made from:
+static bool sourcePath(const char* source, char* path, uint64_t& size, uint64_t& mtime)
+{
+    struct stat st;
+    if (realpath(source, path) == NULL || stat(path, &st) != 0) return false;
+    size  = st.st_size;
+    mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// Hash of a sample of the content: 'source_samples' blocks spread over the file, or all of it when
+// it is smaller. A multi-GB input is not read in full on every load, while a regenerated file with
+// the same size, and a modification time in the same second, is still told apart in most cases.
+static const uint64_t source_samples = 64;
+static const uint64_t source_block   = 4096;
+
+static bool sourceHash(const char* path, uint64_t size, uint64_t& hash)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    unsigned char buf[source_block];
+    uint64_t      nblocks = (size + source_block - 1) / source_block;
+    bool          all     = nblocks <= source_samples;
+    hash = size;
+    for (uint64_t i = 0; i < (all ? nblocks : source_samples); i++){
+        uint64_t off = all ? i * source_block : i * ((size - source_block) / (source_samples - 1));
+        ssize_t  n   = pread(fd, buf, source_block, off);
+        if (n <= 0){
+            close(fd);
+            return false; }
+        hash  = (hash ^ hashBytes(buf, n)) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 31; }
+    close(fd);
+    return true;
+}
+
+// The arena of a cache must be made of whole original clauses over 'nvars' variables, as
+// 'toBinary()' writes them: a truncated or corrupt file is rejected before anything reads through it.
+static bool validArena(const uint32_t* arena, uint32_t words, uint32_t nvars, bool extra)
+{
+    const uint64_t head = sizeof(Clause) / sizeof(uint32_t);
+    for (uint64_t cr = 0; cr < words;){
+        if (words - cr < head) return false;
+        const Clause& c   = *(const Clause*)(arena + cr);
+        uint64_t      len = head + (uint64_t)c.size() + c.has_extra();
+        if (c.size() < 2 || c.learnt() || c.reloced() || c.mark() != 0 || c.has_extra() != extra || len > words - cr)
+            return false;
+        for (int i = 0; i < c.size(); i++)
+            if ((uint32_t)var(c[i]) >= nvars) return false;
+        cr += len; }
+    return true;
+}
+
+
+bool Solver::toBinary(const char* file, const char* source)
+{
+    assert(decisionLevel() == 0 && learnts.size() == 0 && ca.sharedRegion() == NULL);
+
+    BinaryHeader h;
+    char         path[PATH_MAX];
+    if (!sourcePath(source, path, h.source_size, h.source_mtime) || !sourceHash(path, h.source_size, h.source_hash)) return false;
+    if (ca.wasted() > 0) garbageCollect();
+    if (ca.size() > UINT32_MAX) return false;       // (the header counts the arena in 32 bits)
+
+    h.magic   = binary_magic;
+    h.version = binary_version;
+    h.flags   = binaryFlags(ca, ok);
+    h.nvars   = nVars();
+    h.nunits  = trail.size();
+    h.arena   = ca.size();
+    h.path    = strlen(path);
+    h.pad     = 0;
+
+    vec<uint32_t> name(binaryWords(h.path), 0);
+    memcpy((uint32_t*)name, path, h.path);
+
+    FILE* f = fopen(file, "wb");
+    if (f == NULL) return false;
+    bool written = fwrite(&h, sizeof(h), 1, f) == 1
+        && (name.size() == 0 || fwrite((uint32_t*)name, sizeof(uint32_t), name.size(), f) == (size_t)name.size())
+        && (h.nunits == 0 || fwrite((Lit*)trail, sizeof(Lit), h.nunits, f) == h.nunits)
+        && (h.arena  == 0 || fwrite(ca.RegionAllocator<uint32_t>::lea(0), sizeof(uint32_t), h.arena, f) == h.arena);
+    written = fclose(f) == 0 && written;
+    if (!written) ::remove(file);
+    return written;
+}
+
+
+bool Solver::fromBinary(const char* file, const char* source)
+{
+    assert(nVars() == 0 && clauses.size() == 0 && binary_map == NULL);
+
+    uint64_t    size, mtime, hash;
+    char        path[PATH_MAX];
+    struct stat st;
+    int         fd = open(file, O_RDONLY);
+    if (fd < 0) return false;
+    if (!sourcePath(source, path, size, mtime) || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BinaryHeader)){
+        close(fd);
+        return false; }
+    void* map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    // The cheap checks first, the source is only sampled for a cache of the same file, and the
+    // contents are only checked for a cache of the right size:
+    const BinaryHeader& h     = *(const BinaryHeader*)map;
+    const char*         name  = (const char*)map + sizeof(BinaryHeader);
+    uint32_t*           units = (uint32_t*)name + binaryWords(h.path);
+    bool                valid = h.magic == binary_magic && h.version == binary_version
+        && (h.flags & ~binary_unsat) == (binaryFlags(ca, true) & ~binary_unsat)
+        && h.path == strlen(path) && h.nvars <= (uint32_t)INT32_MAX / 2
+        && (uint64_t)st.st_size == sizeof(BinaryHeader) + sizeof(uint32_t) * ((uint64_t)binaryWords(h.path) + h.nunits + h.arena)
+        && memcmp(name, path, h.path) == 0
+        && h.source_size == size && h.source_mtime == mtime && sourceHash(path, size, hash) && h.source_hash == hash
+        && validArena(units + h.nunits, h.arena, h.nvars, h.flags & binary_extra);
+    for (uint32_t i = 0; valid && i < h.nunits; i++)
+        valid = (units[i] >> 1) < h.nvars;
+    if (!valid){
+        munmap(map, st.st_size);
+        return false; }
+
+    binary_map = map;
+    binary_len = st.st_size;
+
+    while (nVars() < (int)h.nvars) newVar();
+    ca.adopt(units + h.nunits, h.arena);
+
+    // Size the watcher lists once, then attach:
+    vec<int> nwatches(2 * nVars(), 0), nimplied(2 * nVars(), 0), nter(2 * nVars(), 0);
+    int      nclauses = 0;
+    for (CRef cr = 0; cr < h.arena; cr = ca.next(cr), nclauses++){
+        const Clause& c = ca[cr];
+        vec<int>&     n = c.size() == 2 ? nimplied : c.size() == 3 ? nter : nwatches;
+        n[toInt(~c[0])]++;
+        n[toInt(~c[1])]++;
+        if (c.size() == 3) n[toInt(~c[2])]++; }
+    for (int i = 0; i < nwatches.size(); i++){
+        watches[toLit(i)].capacity(nwatches[i]);
+        implied[toLit(i)].capacity(nimplied[i]);
+        watchesTer[toLit(i)].capacity(nter[i]); }
+    clauses.capacity(nclauses);
+    for (CRef cr = 0; cr < h.arena; cr = ca.next(cr)){
+        clauses.push(cr);
+        attachClause(cr); }
+
+    if (h.flags & binary_unsat)
+        ok = false;
+    for (uint32_t i = 0; ok && i < h.nunits; i++){
+        Lit p = toLit(units[i]);
+        if      (value(p) == l_False) ok = false;
+        else if (value(p) == l_Undef) uncheckedEnqueue(p); }
+    if (ok)
+        ok = propagate() == CRef_Undef;
+    return true;
+}
+
+
 //=================================================================================================
 // Garbage Collection methods:
 
 void Solver::relocAll(ClauseAllocator& to)
 {
-    // All watchers:
+    // All watchers, in the order of the watcher lists, so that the clauses watched by a literal
+    // sit together. The long clauses, which 'propagate()' reads, come first; the ternary ones are
+    // only read by the conflict analysis:
     //
-    // for (int i = 0; i < watches.size(); i++)
     watches.cleanAll();
-    watchesBin.cleanAll();
+    watchesTer.cleanAll();
     for (int v = 0; v < nVars(); v++)
         for (int s = 0; s < 2; s++){
             Lit p = mkLit(v, s);
@@ -1384,9 +1820,12 @@ void Solver::relocAll(ClauseAllocator& to)
             vec<Watcher>& ws = watches[p];
             for (int j = 0; j < ws.size(); j++)
                 ca.reloc(ws[j].cref, to);
-            vec<Watcher>& ws2 = watchesBin[p];
-            for (int j = 0; j < ws2.size(); j++)
-                ca.reloc(ws2[j].cref, to);
+        }
+    for (int v = 0; v < nVars(); v++)
+        for (int s = 0; s < 2; s++){
+            vec<TerWatcher>& wt = watchesTer[mkLit(v, s)];
+            for (int j = 0; j < wt.size(); j++)
+                ca.reloc(wt[j].cref, to);
         }
 
     // All reasons:
@@ -1394,11 +1833,12 @@ void Solver::relocAll(ClauseAllocator& to)
     for (int i = 0; i < trail.size(); i++){
         Var v = var(trail[i]);
 
-        if (reason(v) != CRef_Undef && (ca[reason(v)].reloced() || locked(ca[reason(v)])))
+        if (reason(v) != CRef_Undef && !isBinReason(v) && (ca[reason(v)].reloced() || locked(ca[reason(v)])))
             ca.reloc(vardata[v].reason, to);
     }
 
-    // All learnt:
+    // All learnt (and original, below), binary clauses included: they keep a record in 'ca' even
+    // though propagation only uses 'implied' (see 'Solver.h'):
     //
     for (int i = 0; i < learnts.size(); i++)
         ca.reloc(learnts[i], to);
@@ -1415,10 +1855,11 @@ void Solver::garbageCollect()
     // Initialize the next region to a size corresponding to the estimated utilization degree. This
     // is not precise but should avoid some unnecessary reallocations for the new region:
     ClauseAllocator to(ca.size() - ca.wasted()); 
+    to.setShared(ca.sharedRegion());
 
     relocAll(to);
     if (verbosity >= 2)
-        printf("|  Garbage collection:   %12d bytes => %12d bytes             |\n", 
-               ca.size()*ClauseAllocator::Unit_Size, to.size()*ClauseAllocator::Unit_Size);
+        printf("|  Garbage collection:   %12llu bytes => %12llu bytes             |\n", 
+               (unsigned long long)ca.size()*ClauseAllocator::Unit_Size, (unsigned long long)to.size()*ClauseAllocator::Unit_Size);
     to.moveTo(ca);
 }
@@ -89,6 +89,10 @@ public:
     bool    addClause (Lit p, Lit q, Lit r);                    // Add a ternary clause to the solver. 
     bool    addClause_(      vec<Lit>& ps);                     // Add a clause to the solver without making superflous internal copy. Will
                                                                 // change the passed vector 'ps'.
+    void    copyProblem(const Solver& from, bool share = false);// Replace the (empty) problem of this solver by a copy of the one loaded
+                                                                // in 'from'. Both solvers must be at decision level 0. If 'share' is set,
+                                                                // the clauses of 'from' are used in place (see 'shareClauses()').
+    void    shareClauses();                                     // Prepare the original clauses to be shared, read-only, by other solvers.
 
     // Solving:
     //
@@ -111,6 +115,11 @@ public:
     void    toDimacs     (const char* file, Lit p);
     void    toDimacs     (const char* file, Lit p, Lit q);
     void    toDimacs     (const char* file, Lit p, Lit q, Lit r);
+
+    bool    toBinary     (const char* file, const char* source);    // Write the problem as a binary cache of the file 'source'.
+    bool    fromBinary   (const char* file, const char* source);    // Load the problem from a binary cache, if it was made from the same
+                                                                    // path and content as 'source'. The clause arena is mapped,
+                                                                    // not copied.
     
     // Variable mode:
     // 
@@ -143,6 +152,9 @@ public:
     void    checkGarbage(double gf);
     void    checkGarbage();
 
+    // An imported learnt of producer 'source' took part in a conflict:
+    virtual void importUsed(int source) {}
+
     // Extra results: (read-only member variable)
     //
     vec<lbool> model;             // If problem is satisfiable, this vector contains the model (if any).
@@ -178,6 +190,7 @@ public:
     bool      rnd_pol;            // Use random polarities for branching heuristics.
     bool      rnd_init_act;       // Initialize variable activities with a small random value.
     double    garbage_frac;       // The fraction of wasted memory allowed before a garbage collection is triggered.
+    int       prefetch;           // Watchers ahead whose clause header is prefetched in 'propagate()' (0=off).
 
     bqueue<unsigned int> trailQueue,lbdQueue; 
     float sumLBD; // used to compute the global average of LBD. Restarts...
@@ -192,8 +205,15 @@ protected:
     long curRestart;
     // Helper structures:
     //
-    struct VarData { CRef reason; int level; };
-    static inline VarData mkVarData(CRef cr, int l){ VarData d = {cr, l}; return d; }
+    // With 'CREF64', VarData and Watcher grow from 8 to 16 bytes (the reference is aligned on 8),
+    // TerWatcher from 12 to 16: the watcher lists take up to twice the cache lines to scan.
+    //
+    // A literal implied by a binary clause has the other (false) literal of the clause as reason,
+    // flagged by 'bin' (see 'isBinReason()'): 'reason' holds 'toInt()' of that literal then, and
+    // no value of 'CRef' is taken for the tag.
+    struct VarData { CRef reason; int level : 31; unsigned bin : 1; };
+    static inline VarData mkVarData   (CRef cr, int l){ VarData d = {cr, l, 0}; return d; }
+    static inline VarData mkBinVarData(Lit q, int l)  { VarData d = {(CRef)toInt(q), l, 1}; return d; }
 
     struct Watcher {
         CRef cref;
@@ -210,6 +230,29 @@ protected:
         bool operator()(const Watcher& w) const { return ca[w.cref].mark() == 1; }
     };
 
+    // Watcher of a ternary clause, in the lists of its three literals: 'other' holds the two
+    // literals left, so that propagation decides on the clause without reading it.
+    struct TerWatcher {
+        CRef cref;
+        Lit  other[2];
+        TerWatcher(CRef cr, Lit p, Lit q) : cref(cr) { other[0] = p, other[1] = q; }
+        bool operator==(const TerWatcher& w) const { return cref == w.cref; }
+        bool operator!=(const TerWatcher& w) const { return cref != w.cref; }
+    };
+
+    struct TerWatcherDeleted
+    {
+        const ClauseAllocator& ca;
+        TerWatcherDeleted(const ClauseAllocator& _ca) : ca(_ca) {}
+        bool operator()(const TerWatcher& w) const { return ca[w.cref].mark() == 1; }
+    };
+
+    // The implications are removed at once (see 'detachClause()'), never marked as deleted.
+    struct ImpliedDeleted
+    {
+        bool operator()(const Lit&) const { return false; }
+    };
+
     struct VarOrderLt {
         const vec<double>&  activity;
         bool operator () (Var x, Var y) const { return activity[x] > activity[y]; }
@@ -224,7 +267,7 @@ protected:
         friend Freeze_params mkFreeze(char confl, bool gel);
     };
 
-    inline  Freeze_params  mkFreeze (char confl, bool gel) { Freeze_params f; f.freeze = gel; f.nb_abs_confl = confl;  }
+    inline  Freeze_params  mkFreeze (char confl, bool gel) { Freeze_params f; f.freeze = gel; f.nb_abs_confl = confl; return f; }
 
     /*FIN RAJOUT STAGE*/
 
@@ -237,10 +280,18 @@ protected:
     double              var_inc;          // Amount to bump next variable with.
     OccLists<Lit, vec<Watcher>, WatcherDeleted>
                         watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
-    OccLists<Lit, vec<Watcher>, WatcherDeleted>
-                        watchesBin;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    OccLists<Lit, vec<TerWatcher>, TerWatcherDeleted>
+                        watchesTer;       // 'watchesTer[lit]' lists the ternary clauses containing '~lit'.
+    OccLists<Lit, vec<Lit>, ImpliedDeleted>
+                        implied;          // 'implied[lit]' lists the literals that binary clauses imply when 'lit' becomes true.
+                                          // The binary clauses deliberately keep their record in 'ca' (listed in 'clauses' or
+                                          // 'learnts', and relocated with them): freezing, the shared problem region, the binary
+                                          // cache and the blocking of models still use it. Propagation, reasons and conflict
+                                          // analysis never read it.
+    Lit                 bin_conflict[2];  // The clause of the conflict when 'propagate()' returns 'CRef_BinConflict'.
     vec<CRef>           clauses;          // List of problem clauses.
     vec<CRef>           learnts;          // List of learnt clauses.
+    vec<ClauseWatch>    shared_watches;   // Watched literals of the problem clauses, when they are shared with other solvers.
 
     /*RAJOUT STAGE*/
 
@@ -270,6 +321,8 @@ protected:
 #endif
 
     ClauseAllocator     ca;
+    void*               binary_map;       // Binary cache the clause arena was loaded from (see 'fromBinary()'), or NULL.
+    size_t              binary_len;
 
     int nbclausesbeforereduce;            // To know when it is time to reduce clause database
     
@@ -295,7 +348,7 @@ protected:
     //
     int64_t             conflict_budget;    // -1 means no budget.
     int64_t             propagation_budget; // -1 means no budget.
-    bool                asynch_interrupt;
+    volatile bool       asynch_interrupt;
 
     // Main internal methods:
     //
@@ -303,16 +356,20 @@ protected:
     Lit      pickBranchLit    ();                                                      // Return the next decision variable.
     void     newDecisionLevel ();                                                      // Begins a new decision level.
     void     uncheckedEnqueue (Lit p, CRef from = CRef_Undef);                         // Enqueue a literal. Assumes value of literal is undefined.
+    void     uncheckedEnqueueBin(Lit p, Lit q);                                        // Enqueue 'p', implied by the binary clause '(p | q)'.
     bool     enqueue          (Lit p, CRef from = CRef_Undef);                         // Test if fact 'p' contradicts current state, enqueue otherwise.
     CRef     propagate        ();                                                      // Perform unit propagation. Returns possibly conflicting clause.
     void     cancelUntil      (int level);                                             // Backtrack until a certain level.
     void     analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel,unsigned int &nblevels);    // (bt = backtrack)
     void     analyzeFinal     (Lit p, vec<Lit>& out_conflict);                         // COULD THIS BE IMPLEMENTED BY THE ORDINARIY "analyze" BY SOME REASONABLE GENERALIZATION?
     bool     litRedundant     (Lit p, uint32_t abstract_levels);                       // (helper method for 'analyze()')
+    bool     unordered        (CRef cr, const Clause& c) const;                        // Whether the implied literal of reason 'cr' may be anywhere in 'c' (shared and ternary clauses are not reordered).
     lbool    search           (int nof_conflicts);                                     // Search for a given number of conflicts.
     lbool    solve_           ();                                                      // Main solve method (assumptions given in 'assumptions').
     void     reduceDB         ();                                                      // Reduce the set of learnt clauses.
     void     removeSatisfied  (vec<CRef>& cs);                                 // Shrink 'cs' to contain only non-satisfied clauses.
+    void     cleanImplied     ();                                              // Drop the implications made useless by the top-level assignment.
+    bool     hasBinary        (Lit p, Lit q);                                  // Is the binary clause '(p | q)' attached already?
     void     rebuildOrderHeap ();
 
     // Maintaining Variable/Clause activity:
@@ -331,13 +388,15 @@ protected:
     bool     locked           (const Clause& c) const; // Returns TRUE if a clause is a reason for some implication in the current state.
     bool     satisfied        (const Clause& c) const; // Returns TRUE if a clause is satisfied in the current state.
 
-    void     relocAll         (ClauseAllocator& to);
+    virtual void relocAll     (ClauseAllocator& to);
 
     // Misc:
     //
     int      decisionLevel    ()      const; // Gives the current decisionlevel.
     uint32_t abstractLevel    (Var x) const; // Used to represent an abstraction of sets of decision levels.
-    CRef     reason           (Var x) const;
+    CRef     reason           (Var x) const;                                          // (not a clause when 'isBinReason(x)')
+    bool     isBinReason      (Var x) const;                                          // Was 'x' implied by a binary clause?
+    Lit      binReasonLit     (Var x) const;                                          // The other literal of that clause.
     int      level            (Var x) const;
     double   progressEstimate ()      const; // DELETE THIS ?? IT'S NOT VERY USEFUL ...
     bool     withinBudget     ()      const;
@@ -363,6 +422,8 @@ protected:
 
 inline CRef Solver::reason(Var x) const { return vardata[x].reason; }
 inline int  Solver::level (Var x) const { return vardata[x].level; }
+inline bool Solver::isBinReason (Var x) const { return vardata[x].bin; }
+inline Lit  Solver::binReasonLit(Var x) const { assert(vardata[x].bin); return toLit((int)vardata[x].reason); }
 
 inline void Solver::insertVarOrder(Var x) {
     if (!order_heap.inHeap(x) && decision[x]) order_heap.insert(x); }
@@ -401,13 +462,20 @@ inline bool     Solver::addClause       (Lit p)                 { add_tmp.clear(
 inline bool     Solver::addClause       (Lit p, Lit q)          { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); return addClause_(add_tmp); }
 inline bool     Solver::addClause       (Lit p, Lit q, Lit r)   { add_tmp.clear(); add_tmp.push(p); add_tmp.push(q); add_tmp.push(r); return addClause_(add_tmp); }
  inline bool     Solver::locked          (const Clause& c) const { 
-   if(c.size()>2) 
-     return value(c[0]) == l_True && reason(var(c[0])) != CRef_Undef && ca.lea(reason(var(c[0]))) == &c; 
-   return 
-     (value(c[0]) == l_True && reason(var(c[0])) != CRef_Undef && ca.lea(reason(var(c[0]))) == &c)
-     || 
-     (value(c[1]) == l_True && reason(var(c[1])) != CRef_Undef && ca.lea(reason(var(c[1]))) == &c);
+   // Binary clauses imply through 'implied': the reason is then the other literal
+   if(c.size()==2){
+     for (int i = 0; i < 2; i++)
+       if (value(c[i]) == l_True && isBinReason(var(c[i])) && binReasonLit(var(c[i])) == c[1-i])
+         return true;
+     return false; }
+   // The implied literal of a ternary clause may be anywhere
+   for (int i = 0; i < (c.size() == 3 ? 3 : 1); i++){
+     CRef r = reason(var(c[i]));
+     if (value(c[i]) == l_True && r != CRef_Undef && !isBinReason(var(c[i])) && ca.lea(r) == &c)
+       return true; }
+   return false;
  }
+inline bool     Solver::unordered       (CRef cr, const Clause& c) const { return ca.isShared(cr) || c.size() == 3; }
 inline void     Solver::newDecisionLevel()                      { trail_lim.push(trail.size());  }
 
 inline int      Solver::decisionLevel ()      const   { return trail_lim.size(); }
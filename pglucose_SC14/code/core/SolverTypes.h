@@ -134,11 +134,12 @@ class Clause {
       unsigned learnt    : 1;
       unsigned has_extra : 1;
       unsigned reloced   : 1;
-      unsigned lbd       : 26;
+      unsigned lbd       : 18;
+      unsigned source    : 8;
       unsigned canbedel  : 1;
       unsigned size      : 32;
     }                            header;
-    union { Lit lit; float act; uint32_t abs; CRef rel; } data[0];
+    union { Lit lit; float act; uint32_t abs; } data[0];
 
     friend class ClauseAllocator;
 
@@ -151,6 +152,7 @@ class Clause {
         header.reloced   = 0;
         header.size      = ps.size();
 	header.lbd = 0;
+	header.source = 0;
 	header.canbedel = 1;
         for (int i = 0; i < ps.size(); i++) 
             data[i].lit = ps[i];
@@ -181,8 +183,10 @@ public:
     const Lit&   last        ()      const   { return data[header.size-1].lit; }
 
     bool         reloced     ()      const   { return header.reloced; }
-    CRef         relocation  ()      const   { return data[0].rel; }
-    void         relocate    (CRef c)        { header.reloced = 1; data[0].rel = c; }
+    // The new reference overwrites the first literals (two of them with 64-bit references):
+    CRef         relocation  ()      const   { CRef c; memcpy(&c, data, sizeof(CRef)); return c; }
+    void         relocate    (CRef c)        { assert(sizeof(CRef) <= sizeof(Lit) * (size() + (int)has_extra()));
+                                               header.reloced = 1; memcpy(data, &c, sizeof(CRef)); }
 
     // NOTE: somewhat unsafe to change the clause in-place! Must manually call 'calcAbstraction' afterwards for
     //       subsumption operations to behave correctly.
@@ -193,63 +197,138 @@ public:
     float&       activity    ()              { assert(header.has_extra); return data[header.size].act; }
     uint32_t     abstraction () const        { assert(header.has_extra); return data[header.size].abs; }
 
+    // Original clauses of a shared region use the extra field to index their 'ClauseWatch':
+    uint32_t     sharedIndex () const        { assert(header.has_extra && !header.learnt); return data[header.size].abs; }
+    void         setSharedIndex(uint32_t i)  { assert(header.has_extra && !header.learnt); data[header.size].abs = i; }
+
     Lit          subsumes    (const Clause& other) const;
     void         strengthen  (Lit p);
-    void         setLBD(int i)  {header.lbd = i;} 
+    void         setLBD(int i)  {header.lbd = i < (1 << 18) ? i : (1 << 18) - 1;} 
     // unsigned int&       lbd    ()              { return header.lbd; }
     unsigned int        lbd    () const        { return header.lbd; }
+    // Imported learnts keep their producer (+1) until first used in a conflict:
+    int          source () const             { return header.source; }
+    void         setSource(int s)            { header.source = s < 256 ? s : 0; }
     void setCanBeDel(bool b) {header.canbedel = b;}
     bool canBeDel() {return header.canbedel;}
 };
 
 
+//=================================================================================================
+// ClauseWatch -- the watched literals of a clause that lives in a shared region:
+//
+// A shared clause is read-only (other solvers propagate on it at the same time), so its literals
+// cannot be reordered to keep the watches in positions 0 and 1. Each solver keeps them here, at
+// the index 'Clause::sharedIndex()'. As for ordinary clauses, 'lit[0]' is the implied literal
+// while the clause is the reason of an assignment.
+
+struct ClauseWatch { Lit lit[2]; };
+
+
 //=================================================================================================
 // ClauseAllocator -- a simple class for allocating memory for clauses:
+//
+// An allocator may be set on top of a read-only region of another allocator: references below
+// 'shared_end' are resolved in that region, and the clauses allocated here get references above
+// it. Shared clauses must never be modified, freed or relocated through this allocator.
+//
+// The allocator that owns such a region is 'lent' (see 'lend()') and may not change anymore: no
+// allocation, free, relocation or move, which would invalidate the region under its readers.
 
 
 const CRef CRef_Undef = RegionAllocator<uint32_t>::Ref_Undef;
+
+// Conflict of a binary clause, whose literals 'Solver::propagate()' leaves in 'bin_conflict' (the
+// reasons of binary clauses are not references, see 'Solver::VarData'). A clause takes more than
+// one word, so no clause starts there: 'ClauseAllocator' only keeps the capacity below it.
+const CRef CRef_BinConflict = CRef_Undef - 1;
+
 class ClauseAllocator : public RegionAllocator<uint32_t>
 {
     static int clauseWord32Size(int size, bool has_extra){
         return (sizeof(Clause) + (sizeof(Lit) * (size + (int)has_extra))) / sizeof(uint32_t); }
+
+    const ClauseAllocator* shared;
+    Ref                    shared_end;
+    bool                   lent;
+
  public:
     bool extra_clause_field;
 
-    ClauseAllocator(uint32_t start_cap) : RegionAllocator<uint32_t>(start_cap), extra_clause_field(false){}
-    ClauseAllocator() : extra_clause_field(false){}
+    ClauseAllocator(Ref start_cap) : RegionAllocator<uint32_t>(start_cap), shared(NULL), shared_end(0), lent(false), extra_clause_field(false){ limit(CRef_BinConflict); }
+    ClauseAllocator() : shared(NULL), shared_end(0), lent(false), extra_clause_field(false){ limit(CRef_BinConflict); }
 
     void moveTo(ClauseAllocator& to){
+        assert(!lent && !to.lent);
         to.extra_clause_field = extra_clause_field;
+        to.shared             = shared;
+        to.shared_end         = shared_end;
         RegionAllocator<uint32_t>::moveTo(to); }
 
+    void copyTo(ClauseAllocator& to) const {
+        to.extra_clause_field = extra_clause_field;
+        to.shared             = shared;
+        to.shared_end         = shared_end;
+        to.limit(CRef_BinConflict - shared_end);
+        RegionAllocator<uint32_t>::copyTo(to); }
+
+    // Use the clauses of 'region' (which must not change anymore) as the shared part of this
+    // allocator. Must be called before any allocation.
+    void setShared(const ClauseAllocator* region){
+        assert(RegionAllocator<uint32_t>::size() == 0);
+        shared     = region;
+        shared_end = region == NULL ? 0 : region->RegionAllocator<uint32_t>::size();
+        limit(CRef_BinConflict - shared_end); }
+    const ClauseAllocator* sharedRegion() const { return shared; }
+    bool          isShared  (Ref r) const { return r < shared_end; }
+
+    // The region is used from now on as the shared part of other allocators (for good):
+    void lend()         { lent = true; }
+    bool isLent() const { return lent; }
+
+    // Make room for 'n' clauses of 'nlits' literals in total, so that allocating them does not
+    // reallocate the region:
+    void reserve(int n, int nlits, bool learnt = false){
+        assert(!lent);
+        RegionAllocator<uint32_t>::reserve((Ref)n * clauseWord32Size(0, learnt | extra_clause_field) + nlits); }
+
     template<class Lits>
     CRef alloc(const Lits& ps, bool learnt = false)
     {
         assert(sizeof(Lit)      == sizeof(uint32_t));
         assert(sizeof(float)    == sizeof(uint32_t));
+        assert(!lent);
         bool use_extra = learnt | extra_clause_field;
 
-        CRef cid = RegionAllocator<uint32_t>::alloc(clauseWord32Size(ps.size(), use_extra));
+        CRef cid = shared_end + RegionAllocator<uint32_t>::alloc(clauseWord32Size(ps.size(), use_extra));
+        assert(cid < CRef_BinConflict);
         new (lea(cid)) Clause(ps, use_extra, learnt);
 
         return cid;
     }
 
     // Deref, Load Effective Address (LEA), Inverse of LEA (AEL):
-    Clause&       operator[](Ref r)       { return (Clause&)RegionAllocator<uint32_t>::operator[](r); }
-    const Clause& operator[](Ref r) const { return (Clause&)RegionAllocator<uint32_t>::operator[](r); }
-    Clause*       lea       (Ref r)       { return (Clause*)RegionAllocator<uint32_t>::lea(r); }
-    const Clause* lea       (Ref r) const { return (Clause*)RegionAllocator<uint32_t>::lea(r); }
-    Ref           ael       (const Clause* t){ return RegionAllocator<uint32_t>::ael((uint32_t*)t); }
+    Clause&       operator[](Ref r)       { return *lea(r); }
+    const Clause& operator[](Ref r) const { return *lea(r); }
+    Clause*       lea       (Ref r)       { return (Clause*)(r < shared_end ? shared->RegionAllocator<uint32_t>::lea(r) : RegionAllocator<uint32_t>::lea(r - shared_end)); }
+    const Clause* lea       (Ref r) const { return (Clause*)(r < shared_end ? shared->RegionAllocator<uint32_t>::lea(r) : RegionAllocator<uint32_t>::lea(r - shared_end)); }
+    Ref           ael       (const Clause* t){ return shared_end + RegionAllocator<uint32_t>::ael((uint32_t*)t); }
+
+    // Reference of the clause stored right after 'r' (to walk through a region without garbage):
+    Ref           next      (Ref r) const { const Clause& c = operator[](r); return r + clauseWord32Size(c.size(), c.has_extra()); }
 
     void free(CRef cid)
     {
+        assert(!isShared(cid) && !lent);
         Clause& c = operator[](cid);
         RegionAllocator<uint32_t>::free(clauseWord32Size(c.size(), c.has_extra()));
     }
 
     void reloc(CRef& cr, ClauseAllocator& to)
     {
+        if (isShared(cr)) return;
+        assert(!lent);
+
         Clause& c = operator[](cr);
         
         if (c.reloced()) { cr = c.relocation(); return; }
@@ -263,6 +342,7 @@ class ClauseAllocator : public RegionAllocator<uint32_t>
         if (to[cr].learnt())        {
 	  to[cr].activity() = c.activity();
 	  to[cr].setLBD(c.lbd());
+	  to[cr].setSource(c.source());
 	  to[cr].setCanBeDel(c.canBeDel());
 	}
         else if (to[cr].has_extra()) to[cr].calcAbstraction();
@@ -295,17 +375,50 @@ class OccLists
         if (dirty[toInt(idx)] == 0){
             dirty[toInt(idx)] = 1;
             dirties.push(idx);
+            if (dirties.size() > 2 * occs.size())
+                forgetClean();
         }
     }
+    void  forgetClean();
 
     void  clear(bool free = true){
         occs   .clear(free);
         dirty  .clear(free);
         dirties.clear(free);
     }
+
+    void  copyTo(OccLists& copy) const {
+        copy.occs.growTo(occs.size());
+        for (int i = 0; i < occs.size(); i++){
+            const Vec& from = occs[i];
+            Vec&       to   = copy.occs[i];
+            to.clear();
+            to.capacity(from.size());
+            for (int j = 0; j < from.size(); j++)
+                to.push_(from[j]);
+        }
+        dirty  .copyTo(copy.dirty);
+        dirties.copyTo(copy.dirties);
+    }
 };
 
 
+// 'lookup()' cleans a list but leaves it in 'dirties', where it may come again when smudged later:
+// drop these entries once they may outnumber the lists.
+template<class Idx, class Vec, class Deleted>
+void OccLists<Idx,Vec,Deleted>::forgetClean()
+{
+    int i, j;
+    for (i = j = 0; i < dirties.size(); i++)
+        if (dirty[toInt(dirties[i])] == 1){
+            dirty[toInt(dirties[i])] = 2;     // (keeps a single entry per list)
+            dirties[j++] = dirties[i]; }
+    dirties.shrink(i - j);
+    for (i = 0; i < dirties.size(); i++)
+        dirty[toInt(dirties[i])] = 1;
+}
+
+
 template<class Idx, class Vec, class Deleted>
 void OccLists<Idx,Vec,Deleted>::cleanAll()
 {
@@ -6,34 +6,165 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <sstream>
+#include <sched.h>
 using namespace Glucose;
 
+static const int filter_size = 1 << 16;
+
+//Order independent hash of a set of literals
+static inline uint64_t hashLits(const vec<Lit>& ps) {
+  uint64_t s = ps.size(), x = 0;
+  for (int i=0; i<ps.size(); i++) {
+    uint64_t m = (uint64_t)toInt(ps[i]) * 0x9E3779B97F4A7C15ULL;
+    m ^= m >> 29; m *= 0xBF58476D1CE4E5B9ULL; m ^= m >> 32;
+    s += m;
+    x ^= m;
+  }
+  uint64_t h = s ^ (x << 31 | x >> 33);
+  return h ? h : 1;
+}
+
 int pSolver::nbworkers=0;
 pSolver ** pSolver::solvers=0;
-int pSolver::folio=false;
+int pSolver::modelset=0;
+bool pSolver::pinning=false;
+vec<int> pSolver::cpu_order;
+bool pSolver::counting=false;
+int pSolver::pool_cmd=pSolver::cmd_none;
+unsigned int pSolver::pool_epoch=0;
+unsigned int pSolver::pool_base=0;
+bool pSolver::pool_started=false;
+int pSolver::pool_busy=0;
+pthread_mutex_t pSolver::pool_mutex=PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t pSolver::pool_cmd_cond=PTHREAD_COND_INITIALIZER;
+pthread_cond_t pSolver::pool_done_cond=PTHREAD_COND_INITIALIZER;
 Queue<Lit> pSolver::vars;
 
 // This method executes the main procedure 
-// of the resolution process:  a thread starts
-// first in portfolio mode then switches   
-// to divide and conquer mode. When it terminates 
-// it goes in a spin loop waiting a cancellation
-// signal from the pricipal process
+// of the resolution process: the thread is
+// created once and runs the commands of the
+// pricipal process, first the portfolio mode
+// then the divide and conquer mode, until
+// cmd_quit. A command ends when it terminates
+// or when it is stopped (see stopWorkers)
 
 /*RAJOUT STAGE*/
 
 
 void* pSolver::thread_work() {
-  if(!folio) 
-    searchSubProblem();
-  else
-    getPromisingOrder();
+  unsigned int epoch = pool_base;
 
-  while(true) usleep(5000);
+  if (pinning)
+    pinThread(id - 1);
+  //Its ring of shared learnts is first touched on its node
+  sharedBase->attach(id);
+
+  while (true) {
+    pthread_mutex_lock(&pool_mutex);
+    while (pool_epoch == epoch)
+      pthread_cond_wait(&pool_cmd_cond, &pool_mutex);
+    epoch = pool_epoch;
+    int cmd = pool_cmd;
+    pthread_mutex_unlock(&pool_mutex);
+
+    if (cmd == cmd_quit)
+      return 0;
+    if (cmd == cmd_portfolio)
+      getPromisingOrder();
+    else
+      searchSubProblem();
+
+    pthread_mutex_lock(&pool_mutex);
+    pool_busy--;
+    pthread_cond_broadcast(&pool_done_cond);
+    pthread_mutex_unlock(&pool_mutex);
+  }
 
   return 0;
 }
 
+//Bind the calling thread to the k-th cpu of cpu_order, so
+//that a worker keeps its caches and its memory node: the
+//consecutive workers fill a node before the next one
+void pSolver::pinThread(int k) {
+#ifdef __linux__
+  if (cpu_order.size() == 0)
+    return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu_order[k % cpu_order.size()], &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+//List the cpus the process may run on, node by node as given
+//by sysfs ("0-7,16-23"), those of no node last. Called by the
+//main thread before any worker is pinned.
+void pSolver::orderCpus() {
+#ifdef __linux__
+  if (cpu_order.size() > 0)
+    return;
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return;
+  vec<char> listed(CPU_SETSIZE, 0);
+  for (int node=0; node<256; node++){
+    char path[64];
+    sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (f == NULL)
+      continue;
+    int a, b, c;
+    while (fscanf(f, "%d", &a) == 1){
+      b = a;
+      if ((c = fgetc(f)) == '-' && fscanf(f, "%d", &b) == 1)
+	c = fgetc(f);
+      for (int x=a; x<=b && x<CPU_SETSIZE; x++)
+	if (CPU_ISSET(x, &allowed) && !listed[x]){
+	  listed[x] = 1;
+	  cpu_order.push(x);
+	}
+      if (c != ',')
+	break;
+    }
+    fclose(f);
+  }
+  for (int x=0; x<CPU_SETSIZE; x++)
+    if (CPU_ISSET(x, &allowed) && !listed[x])
+      cpu_order.push(x);
+#endif
+}
+
+//Start the workers 1..nbworkers-1, waiting for a command
+void pSolver::startPool(pSolver *data[]){
+  if (pool_started)
+    return;
+  if (pinning)
+    orderCpus();
+  pool_started = true;
+  pool_base = pool_epoch;
+  for (int i=1; i<nbworkers; i++)
+    sharedJob->tids[i-1]=create_worker(data[i]);
+}
+
+//Hand a command over to all the workers
+void pSolver::runPhase(int cmd){
+  pthread_mutex_lock(&pool_mutex);
+  pool_cmd = cmd;
+  pool_epoch++;
+  pool_busy = nbworkers-1;
+  pthread_cond_broadcast(&pool_cmd_cond);
+  pthread_mutex_unlock(&pool_mutex);
+}
+
+//Terminate the workers once they are stopped
+void pSolver::quitPool(){
+  runPhase(cmd_quit);
+  for (int i=1; i<nbworkers; i++)
+    pthread_join(sharedJob->tids[i-1], NULL);
+  pool_started = false;
+}
+
 //The bootstrap function that have to be 
 //executed by each process
 void* pSolver::bootstrap(void * arg) {
@@ -48,6 +179,37 @@ pthread_t pSolver::create_worker(void *arg) {
   return tid;
 }
 
+//Each worker copies, in its own thread, the
+//problem parsed by the first solver. Pinned on the
+//cpu of the worker, the copy lands on its node.
+void* pSolver::copy_bootstrap(void * arg) {
+  pSolver* solver = (pSolver *)arg;
+  if (pinning)
+    pinThread(solver->id - 1);
+  solver->copyProblem(*solvers[0], solver->shareorig);
+  return 0;
+}
+
+//Build the problem of the workers 1..t-1 from 
+//the one parsed by data[0]: the input is read only 
+//once, then copied in parallel. With shareorig, the
+//clauses of data[0] are not copied but shared.
+void pSolver::replicate(int t, pSolver *data[]) {
+  pthread_t *tids = new pthread_t[t];
+
+  solvers=data;
+  if (pinning)
+    orderCpus();
+  if(data[0]->shareorig)
+    data[0]->shareClauses();
+  for (int i=1; i<t; i++)
+    pthread_create(&tids[i], 0, &pSolver::copy_bootstrap, data[i]);
+  for (int i=1; i<t; i++)
+    pthread_join(tids[i], NULL);
+
+  delete[] tids;
+}
+
 //Replay a set of assignements 
 //to position back the solver to 
 //a certain point.
@@ -83,7 +245,7 @@ void pSolver::getfirstLits(){
   Lit   l=lit_Undef;
   do 
       l = pickBranchLit();
-  while(watches[l].size() == 0);
+  while(watches[l].size() == 0 && watchesTer[l].size() == 0);
   random_var_freq=0;
 
   for(int i=0; i <nbworkers-1;++i)
@@ -93,15 +255,16 @@ void pSolver::getfirstLits(){
    
     for(int i=0; i <nbworkers-1;++i){
       Lit e = vars.peek(); vars.pop();
-      vec<Watcher>&  ws  = watches[e];
-      int cl= irand(random_seed, ws.size());
-      Clause&  c         = ca[ws[cl].cref];
+      vec<Watcher>&     ws  = watches[e];
+      vec<TerWatcher>&  wt  = watchesTer[e];
+      int cl= irand(random_seed, ws.size() + wt.size());
+      Clause&  c         = ca[cl < ws.size() ? ws[cl].cref : wt[cl - ws.size()].cref];
 
       Lit li= e;
       
       for(int k=0; k <c.size();++k){
 	if( c[k] != e && 
-	    watches[c[k]].size() == 0 &&
+	    watches[c[k]].size() == 0 && watchesTer[c[k]].size() == 0 &&
 	    value(c[k]) != l_Undef){
 	  li = c[k];
 	  break;
@@ -134,6 +297,7 @@ void  pSolver::getPromisingOrder(){
   trailQueue.initSize(sizeTrailQueue);
   nbclausesbeforereduce = firstReduceDB;    
   cancelUntil(0);
+  user_assumps.copyTo(assumptions);
   
   solves++;  
 
@@ -147,36 +311,30 @@ void  pSolver::getPromisingOrder(){
   //Perform a CDCL search process on the problem
   //Beside, learn new clauses from othern workers.  
   while( l_Undef == ( ret =  search(next)) ){
-    pthread_testcancel();   
+    //Stopped by the coordinator
+    if (asynch_interrupt)
+      return;
     //Update the DB of learned clauses by
     //those of other workers
     sharedBase->update(this);
     next =lit_Undef;
+
+    //Let the coordinator check grestart()
+    if ((double)learnts.size() >= pfstopDB * (double)clauses.size())
+      sharedJob->notify();
   }
     
   //The problem is SAT
   if (ret == l_True) {
-    mpz_t tmp;  
-    mpz_init(tmp);
     thtime += cpuThreadTime(); 
-    mpz_set_si(tmp, 1);
-    sharedJob->putResult(tmp);
-    mpz_clear(tmp); 
-    
-    solvers[0]->model.growTo(nVars());
-    for (int i = 0; i < nVars(); i++) 
-      solvers[0]->model[i] = value(i);
+    storeModel();
     return;
   } 
  
   //The problem is UNSAT
   if (ret == l_False) {
-    mpz_t tmp;  
-    mpz_init(tmp);
     thtime += cpuThreadTime(); 
-    mpz_set_si(tmp, -1);
-    sharedJob->putResult(tmp);
-    mpz_clear(tmp); 
+    sharedJob->putResult(l_False, id);
     return;
   } 
  
@@ -199,34 +357,41 @@ void pSolver::searchSubProblem() {
 
   while (true) {
   start:
+    if (asynch_interrupt)
+      return;
     sumLBD = 0; conflicts=0;
     lbdQueue.initSize(sizeLBDQueue);
     trailQueue.initSize(sizeTrailQueue);
     nbclausesbeforereduce = firstReduceDB;    
     cancelUntil(0);
         
-    if (!sharedJob->pop(assumptions)) {
-      mpz_t tmp;  
-      mpz_init(tmp);
-      mpz_set_si(tmp, -1);
-      sharedJob->putResult(tmp);
-      mpz_clear(tmp); 
+    if (!sharedJob->pop(assumptions, id)) {
+      //No result when the coordinator stopped the search
+      if (asynch_interrupt)
+	return;
+      failAssumptions();
       thtime += cpuThreadTime();
       break;
     }
     
     solves++;  
+    conflict.clear();
+    job_models = nbmodels;
 
     //Decompose the subproblem if it
-    //is the last in the queue
-    if(nAssigns() <= percentage * nVars() &&
+    //is the last in the queue (not when counting:
+    //the cube of a model would come back forever)
+    if(!counting &&
+       nAssigns() <= percentage * nVars() &&
        sharedJob->getJobLeft() ==0){
       
       if(playAssumptions() == l_False){
 	goto start;
       }
-      else
-	 createJobs(decisionLevel()+sharedJob->getHeight());
+      else if(createJobs(decisionLevel()+sharedJob->getHeight())){
+	storeModel();
+	break;
+      }
       continue;
     }
     
@@ -235,9 +400,11 @@ void pSolver::searchSubProblem() {
     //Perform a CDCL search process on the
     //subproblem while it is Undef: not known to be SAT or UNSAT.
     //Beside, learn new clauses from othern workers.  
-    while( l_Undef == ( ret =  search(0)) ){
+    while( l_Undef == ( ret =  counting ? countModels() : search(0)) ){
       
-      pthread_testcancel();   
+      //Stopped by the coordinator
+      if (asynch_interrupt)
+	return;
 
       //Update the DB of learned clauses by
       //those of other workers
@@ -247,39 +414,31 @@ void pSolver::searchSubProblem() {
       //the number of assigned variables is less
       //than a percentage, and there is some idle thread
       //then decompose the subproblem.
-      if(nAssigns() <= percentage * nVars() &&
+      if(canSplit() &&
+	 nAssigns() <= percentage * nVars() &&
 	 sharedJob->getJobLeft() ==0){
 	if(playAssumptions() == l_False)
 	  goto start;
-	else
-	   createJobs(decisionLevel()+sharedJob->getHeight());
+	else if(createJobs(decisionLevel()+sharedJob->getHeight())){
+	  storeModel();
+	  return;
+	}
 	break;
       }
     }
     
     //The problem is SAT 
     if (ret == l_True) {
-      mpz_t tmp;  
-      mpz_init(tmp);
       thtime += cpuThreadTime(); 
-      mpz_set_si(tmp, 1);
-      sharedJob->putResult(tmp);
-      mpz_clear(tmp);
       std::cout << "Solution Thread="<< id <<std::endl;
-      solvers[0]->model.growTo(nVars());
-      for (int i = 0; i < nVars(); i++) 
-	solvers[0]->model[i] = value(i);
+      storeModel();
       break;
     }
 
-    //The problem is UNSAT
-    if (ret == l_False && decisionLevel() == 0) {
-      mpz_t tmp;  
-      mpz_init(tmp);
+    //The problem is UNSAT (a refuted cube sets 'conflict')
+    if (ret == l_False && conflict.size() == 0) {
       thtime += cpuThreadTime(); 
-      mpz_set_si(tmp, -1);
-      sharedJob->putResult(tmp);
-      mpz_clear(tmp); 
+      sharedJob->putResult(l_False, id);
       break;
     } 
  
@@ -288,15 +447,19 @@ void pSolver::searchSubProblem() {
 
 //This procedure generates subproblems the 
 //assumption of which have a size of h (the numbre of 
-//decision levels is g. t. e. to h)
-bool pSolver::createJobs(unsigned int h){
+//decision levels is g. t. e. to h). They are pushed on
+//the deque of 'owner', by default this worker.
+bool pSolver::createJobs(unsigned int h, int owner){
   assert(ok); 
 
+  if (asynch_interrupt)
+    return false;
+
  
   // Unit propagation
   CRef confl = propagate();
 
-  if ((unsigned) confl != CRef_Undef){
+  if (confl != CRef_Undef){
     // CONFLICT : just store the learnt clause.
     int         backtrack_level;
     vec<Lit>    learnt_clause;
@@ -330,40 +493,296 @@ bool pSolver::createJobs(unsigned int h){
   }else{
 
     //The decion level 'h' is reached:
-    // inqueue the new found job and return
+    // inqueue the new found job, made of
+    // its decisions only, and return
     if(decisionLevel()>=(int)h){
-      sharedJob->push(trail);
+      pushCube(owner);
       return false;
     }
 
     decisions++;
     
-    Lit next =  pickBranchLit();
+    Lit next;
+    bool forced = false;
+    if (split == split_lookahead){
+      next = lookaheadLit(forced);
+      //Both polarities fail: the cube is refuted
+      if (next == lit_Error)
+	return false;
+    }else
+      next = pickBranchLit();
    
     // If all vars are assigned 
     if (next == lit_Undef){
+      //A model, counted by the worker of its cube
+      if (counting){
+	pushCube(owner);
+	return false;
+      }
       std::cout << "Create Job Thread="<< id <<std::endl;
       return true;
     }
     // At least one var is not assigned, 
     // compute create a branch for next
-    // and an other for !next
+    // and an other for !next, unless
+    // !next was refuted by the lookahead
     else {
       newDecisionLevel();
       uncheckedEnqueue(next);
       bool res=false;
-      if (!(res= createJobs(h))){
+      if (!(res= createJobs(h, owner)) && !forced){
 	cancelUntil(decisionLevel()-1);
 	newDecisionLevel();
 	uncheckedEnqueue(~next);
-	res =  createJobs(h);
+	res =  createJobs(h, owner);
 	cancelUntil(decisionLevel()-1);
       }
+      else if (!res)
+	cancelUntil(decisionLevel()-1);
       return res;
     }
   }  
 }
 
+//All the cubes are refuted: UNSAT under the user assumptions,
+//all of them being the final conflict (the core of each cube
+//is not tracked)
+void pSolver::failAssumptions(){
+  conflict.clear();
+  for (int i=0; i<user_assumps.size(); i++)
+    conflict.push(~user_assumps[i]);
+  sharedJob->putResult(l_False, id);
+}
+
+//Push the decisions of the current levels as a job
+void pSolver::pushCube(int owner){
+  cube.clear();
+  for (int i=0; i<decisionLevel(); i++){
+    int end = i+1 < decisionLevel() ? trail_lim[i+1] : trail.size();
+    //Skip the dummy levels of implied assumptions
+    if (trail_lim[i] < end)
+      cube.push(trail[trail_lim[i]]);
+  }
+  sharedJob->push(cube, owner < 0 ? id : owner);
+}
+
+//Split literal of a cube, by failed literal probing of the
+//'split_cands' most active unassigned variables: the variable
+//whose polarities propagate the most (march-like product of
+//their counts) is chosen. When one polarity fails, the other
+//is returned as 'forced'; lit_Error when both fail.
+Lit pSolver::lookaheadLit(bool& forced){
+  probe_vars.clear();
+  while (probe_vars.size() < split_cands && !order_heap.empty()){
+    Var v = order_heap.removeMin();
+    if (value(v) == l_Undef && decision[v])
+      probe_vars.push(v);
+  }
+  for (int i=0; i<probe_vars.size(); i++)
+    insertVarOrder(probe_vars[i]);
+
+  Lit best = lit_Undef;
+  uint64_t best_score = 0;
+  forced = false;
+  for (int i=0; i<probe_vars.size(); i++){
+    Var v = probe_vars[i];
+    int count[2];
+    bool failed[2];
+    for (int s=0; s<2; s++){
+      int before = trail.size();
+      newDecisionLevel();
+      uncheckedEnqueue(mkLit(v, s));
+      failed[s] = propagate() != CRef_Undef;
+      count[s] = trail.size() - before;
+      cancelUntil(decisionLevel()-1);
+    }
+    if (failed[0] && failed[1])
+      return lit_Error;
+    if (failed[0] || failed[1]){
+      forced = true;
+      return mkLit(v, failed[0]);
+    }
+    uint64_t score = (uint64_t)(count[0]+1) * (count[1]+1);
+    if (best == lit_Undef || score > best_score){
+      best = mkLit(v, count[0] < count[1]);
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+//Give the complementary half of the current cube away:
+//the first decision 'd' taken after the assumptions is
+//kept as a new assumption, the cube with ~d is pushed
+void pSolver::splitCube(){
+  Lit d = trail[trail_lim[assumptions.size()]];
+  assumptions.copyTo(cube);
+  cube.push(~d);
+  sharedJob->push(cube, id);
+  assumptions.push(d);
+  nbsplits++;
+}
+
+//The first worker finding a model stores it, 
+//before the result wakes up the coordinator
+void pSolver::storeModel(){
+  if (!__sync_bool_compare_and_swap(&modelset, 0, 1))
+    return;
+  solvers[0]->model.growTo(nVars());
+  for (int i = 0; i < nVars(); i++) 
+    solvers[0]->model[i] = value(i);
+
+  sharedJob->putResult(l_True, id);
+}
+
+//Search the cube for all its models: each one found is counted
+//and blocked. l_False once the cube has no model left, l_Undef
+//on a restart or an interruption.
+lbool pSolver::countModels(){
+  lbool ret;
+  while ((ret = search(0)) == l_True)
+    if (!blockModel())
+      return l_False;
+  return ret;
+}
+
+//A clause to satisfy by the counted cubes, found through its
+//first literal until the next model
+template<class Lits>
+void pSolver::addCountClause(const Lits& c){
+  count_watches[toInt(c[0])].push(count_clauses.size());
+  count_clauses.push();
+  for (int i=0; i<c.size(); i++)
+    count_clauses.last().push(c[i]);
+}
+
+//The true literal of 'c' assigned at the lowest level
+//(lit_Undef for a removed clause)
+Lit pSolver::lowestTrue(const vec<Lit>& c) const {
+  Lit w = lit_Undef;
+  for (int t=0; t<c.size(); t++)
+    if (value(c[t]) == l_True && (w == lit_Undef || level(var(c[t])) < level(var(w))))
+      w = c[t];
+  assert(w != lit_Undef || c.size() == 0);
+  return w;
+}
+
+//Count the models of the shortest prefix of the trail, up to
+//a decision level j, that satisfies all the clauses (the
+//blocking ones too, for disjoint counts), and block them with
+//the negation of the decisions of the levels 1..j. The models
+//of these decisions all extend the prefix, so they are all
+//counted here. j covers the assumptions: the cubes count
+//disjoint models. Each clause is found through a true literal
+//(count_watches), searched again only when it becomes false or
+//lies above j, so that a model does not scan them all. The
+//search goes on next to the cube, from the level where the
+//blocking clause becomes unit, as with a learnt clause.
+//False when the blocking clause is empty.
+bool pSolver::blockModel(){
+  assert(trail.size() == nVars());
+  if (count_watches.size() == 0){
+    count_watches.growTo(2*nVars());
+    for (int i=0; i<clauses.size(); i++)
+      if (ca[clauses[i]].mark() != 1)
+	addCountClause(ca[clauses[i]]);
+  }
+
+  //Move the clauses off their false literals, to their true
+  //literal of the lowest level
+  for (int i=0; i<trail.size(); i++){
+    vec<int>& ws = count_watches[toInt(~trail[i])];
+    for (int k=0; k<ws.size(); k++){
+      Lit w = lowestTrue(count_clauses[ws[k]]);
+      if (w != lit_Undef)
+	count_watches[toInt(w)].push(ws[k]);
+    }
+    ws.clear();
+  }
+
+  //From the last level down, move the clauses of the true
+  //literals too, until one of them has to stay: j is its level
+  int j = assumptions.size() < decisionLevel() ? assumptions.size() : decisionLevel();
+  for (int i=trail.size()-1; i>=0 && level(var(trail[i])) > j; i--){
+    vec<int>& ws = count_watches[toInt(trail[i])];
+    int k, l;
+    for (k=l=0; k<ws.size(); k++){
+      Lit w = lowestTrue(count_clauses[ws[k]]);
+      if (w == lit_Undef)
+	continue;
+      if (level(var(w)) == level(var(trail[i])))
+	ws[l++] = ws[k];
+      else
+	count_watches[toInt(w)].push(ws[k]);
+    }
+    ws.shrink(k - l);
+    if (l > 0)
+      j = level(var(trail[i]));
+  }
+
+  //The last decision first, then the one before (the watches)
+  block.clear();
+  for (int l=j; l>=1; l--){
+    int end = l < decisionLevel() ? trail_lim[l] : trail.size();
+    if (trail_lim[l-1] < end)
+      block.push(~trail[trail_lim[l-1]]);
+  }
+
+  mpz_t n;
+  mpz_init(n);
+  mpz_setbit(n, nVars() - (j < decisionLevel() ? trail_lim[j] : trail.size()));
+  sharedJob->addCount(n);
+  mpz_clear(n);
+  nbmodels++;
+
+  if (block.size() == 0)
+    return false;
+  cancelUntil(block.size() == 1 ? 0 : level(var(block[1])));
+
+  //The blocking clauses of the cubes under these decisions,
+  //the last ones, are subsumed: they are removed
+  count_mark.growTo(2*nVars(), 0);
+  for (int i=0; i<block.size(); i++)
+    count_mark[toInt(block[i])] = 1;
+  while (count_blocks.size() > 0){
+    vec<Lit>& c = count_clauses[count_blocks.last().id];
+    int in = 0;
+    for (int t=0; t<c.size(); t++)
+      in += count_mark[toInt(c[t])];
+    if (in < block.size() || locked(ca[count_blocks.last().cr]))
+      break;
+    removeClause(count_blocks.last().cr);
+    c.clear(true);
+    count_blocks.pop();
+  }
+  for (int i=0; i<block.size(); i++)
+    count_mark[toInt(block[i])] = 0;
+  //The removed blocks would otherwise wait for the next reduction of the learnts
+  if ((nbmodels & 63) == 0)
+    checkGarbage();
+
+  addCountClause(block);
+  if (block.size() == 1)
+    uncheckedEnqueue(block[0]);
+  else{
+    CountBlock b = { ca.alloc(block, false), count_clauses.size()-1 };
+    count_blocks.push(b);
+    attachClause(b.cr);
+    if (block.size() == 2)
+      uncheckedEnqueueBin(block[0], block[1]);
+    else
+      uncheckedEnqueue(block[0], b.cr);
+  }
+  return true;
+}
+
+//The blocking clauses are not in 'clauses'
+void pSolver::relocAll(ClauseAllocator& to){
+  Solver::relocAll(to);
+  for (int i=0; i<count_blocks.size(); i++)
+    ca.reloc(count_blocks[i].cr, to);
+}
+
 //The CDCL procedure is encoded here
 lbool pSolver::search(int nof_conflicts)
 {
@@ -378,7 +797,8 @@ lbool pSolver::search(int nof_conflicts)
   
   for (;;){
 
-    pthread_testcancel();
+    if (asynch_interrupt)
+      return l_Undef;
     CRef confl = propagate();
     
   
@@ -421,8 +841,7 @@ lbool pSolver::search(int nof_conflicts)
       lbdQueue.push(nblevels);
       sumLBD += nblevels;
   
-      if (nblevels <= maxsizeshared)
-	sharedBase->push(learnt_clause, nblevels,this);
+      exportLearnt(learnt_clause, nblevels);
       
       cancelUntil(backtrack_level);
 	    
@@ -446,10 +865,16 @@ lbool pSolver::search(int nof_conflicts)
 	attachClause(cr);
 	      
 	claBumpActivity(ca[cr]);
-	uncheckedEnqueue(learnt_clause[0], cr);
+	if (learnt_clause.size() == 2) uncheckedEnqueueBin(learnt_clause[0], learnt_clause[1]);
+	else                           uncheckedEnqueue(learnt_clause[0], cr);
       }
       varDecayActivity();
       claDecayActivity();
+
+      //An idle worker waits for a job
+      if (decisionLevel() > assumptions.size() && canSplit() &&
+	  sharedJob->takeSplitRequest())
+	splitCube();
 	
     }else{
 
@@ -486,7 +911,9 @@ lbool pSolver::search(int nof_conflicts)
 	  // Dummy decision level:
 	  newDecisionLevel();
 	}else if (value(p) == l_False){
-	  // analyzeFinal(~p, conflict);
+	  // The cube is refuted, not the problem:
+	  conflict.clear();
+	  conflict.push(~p);
 	  return l_False;
 	}else{
 	  next = p;
@@ -500,7 +927,8 @@ lbool pSolver::search(int nof_conflicts)
 	next = pickBranchLit();
 	// The problem is solved 
 	if (next == lit_Undef){
-	  std::cout << "Search Thread="<< id <<std::endl;
+	  if (!counting)
+	    std::cout << "Search Thread="<< id <<std::endl;
 	  return l_True;
 	}
       }
@@ -528,7 +956,8 @@ lbool pSolver::search( Lit next )
 
   for (;;){
     
-    pthread_testcancel();
+    if (asynch_interrupt)
+      return l_Undef;
     //Effectue la propagation unitaire, retourne une clause de conflit s'il y en a une
     CRef confl = propagate();
     //Si clause de conflit trouvée, alors
@@ -581,8 +1010,7 @@ lbool pSolver::search( Lit next )
 
       //S'il reste de la place dans la file de partage, alors partager
       // la clause apprise
-      if (nblevels <=maxsizeshared)
-      	sharedBase->push(learnt_clause, nblevels,this);
+      exportLearnt(learnt_clause, nblevels);
       //Annule toutes les affectations faites, avec trail et trail_lim + decisions tableau
       //revient en quelque sorte au dernier niveau de decision
       cancelUntil(backtrack_level);
@@ -611,7 +1039,8 @@ lbool pSolver::search( Lit next )
 
 	      
 	claBumpActivity(ca[cr]);
-	uncheckedEnqueue(learnt_clause[0], cr);
+	if (learnt_clause.size() == 2) uncheckedEnqueueBin(learnt_clause[0], learnt_clause[1]);
+	else                           uncheckedEnqueue(learnt_clause[0], cr);
       }
       varDecayActivity();
       claDecayActivity();
@@ -640,6 +1069,19 @@ lbool pSolver::search( Lit next )
 	  reduceDB();
 	  nbclausesbeforereduce += incReduceDB;
 	}	    
+
+      while (next == lit_Undef && decisionLevel() < assumptions.size()){
+	// Perform user provided assumption:
+	Lit p = assumptions[decisionLevel()];
+	if (value(p) == l_True){
+	  // Dummy decision level:
+	  newDecisionLevel();
+	}else if (value(p) == l_False){
+	  analyzeFinal(~p, conflict);
+	  return l_False;
+	}else
+	  next = p;
+      }
    
       if (next == lit_Undef){
 	// New variable decision:
@@ -682,6 +1124,21 @@ bool pSolver::grestart(pSolver *data[]){
   return true;
 }
 
+//Stop the workers at their next check of asynch_interrupt
+//(search, createJobs, the job loop) and wait for them to be
+//back in the pool: they return without a result, at a clean point.
+void pSolver::stopWorkers(pSolver *data[]){
+  for (int i=1; i<nbworkers; i++)
+    data[i]->interrupt();
+  sharedJob->endAll();
+  pthread_mutex_lock(&pool_mutex);
+  while (pool_busy > 0)
+    pthread_cond_wait(&pool_done_cond, &pool_mutex);
+  pthread_mutex_unlock(&pool_mutex);
+  for (int i=1; i<nbworkers; i++)
+    data[i]->clearInterrupt();
+}
+
 //To start the divide an conquer phase, 
 //we chose the liternals' order given 
 //by the worker which progressed the best.
@@ -715,23 +1172,29 @@ int pSolver::getbpick(pSolver *data[]){
 
 //The initialisation method. It starts 
 //all other threads and wait for the
-//termination of one of theim. 
+//termination of one of theim. The workers
+//wake it up through sharedJob: with a result,
+//or in the portfolio phase once they
+//learnt enough for grestart().
 void pSolver::solveMultiThreaded(int h, int t, pSolver *data[]){
   
   nbworkers=t;
   // getfirstLits();
   solvers=data;
-  mpz_t ret;
-  mpz_init(ret);
-  mpz_set_si(ret,0);    
   bool rstart=true;
   int curr_restarts =0;
   double rest_base = restart_base; 
-  long long cpt=0;
+  unsigned int seen=0;
+  double deadline=0;
  
 
   if (!ok) return;
 
+  //A new result, possibly under other assumptions
+  modelset = 0;
+  sharedJob->clearResult();
+  sharedJob->init(nbworkers, h, 1<<h);
+
   sumLBD = 0;  
   lbdQueue.initSize(sizeLBDQueue);
   trailQueue.initSize(sizeTrailQueue);
@@ -760,54 +1223,43 @@ void pSolver::solveMultiThreaded(int h, int t, pSolver *data[]){
       printf("c =========================================================================================================\n");
    }
 
-   folio =true;
    // Le thread initil v creer un ensemble de "workers" ( = nb threads précisés => nb coeurs du systeme)
    // Crée un thread, avec bootstrap comme fonction, tetourne de TID, qu'on stoque précieusement dans la structure sharedJob.
    // Chaque thread disposera donc de data[i] => sa file de clauses à partager.
-   for (int i=1; i<nbworkers; i++)
-     sharedJob->tids[i-1]=create_worker(data[i]);
+   // Les mêmes threads servent ensuite pour toutes les phases.
+   startPool(data);
+   if (!counting)
+     runPhase(cmd_portfolio);
    
-   while (true){
+   //Counting starts with the cubes: the portfolio stops at the first model
+   while (!counting){
      
-     usleep(5000);
+     sharedJob->waitEvent(seen, 0);
      
-     sharedJob->getResult(ret);
-     // Attente 0.5 (??) secs, regarde le resultat obtenu  
-     // Si ret != 0 , donc si VRAI, ALORS 
-     if (stop(ret)){       
-      // Annulation + attente de terminaison, car pthread_cancel provoque pthread_exit.
-       for (int i=1; i<nbworkers; i++){
-	 pthread_cancel(sharedJob->tids[i-1]);
-	 pthread_join(sharedJob->tids[i-1], NULL);
-       }
+     // Si un resultat est connu, ALORS 
+     if (stop()){       
+       stopWorkers(data);
+       leavePool();
 
        if (verbosity >= 1)
 	 printf("c =========================================================================================================\n");
-       
-       mpz_clear(ret);
 
        return;
      }
 
      // 5 % clauses nouvelles apprises
      if(grestart(data)){
-       for (int i=1; i<nbworkers; i++){
-	 pthread_cancel(sharedJob->tids[i-1]);
-	 pthread_join(sharedJob->tids[i-1], NULL); 
-       }
-
-       folio =false;
+       stopWorkers(data);
        break;
      }
        
    }
 
-   sharedJob->getResult(ret);
-   if ( stop(ret)){
+   if ( stop()){
+     leavePool();
      if (verbosity >= 1)
        printf("c =========================================================================================================\n");
      
-     mpz_clear(ret);
      return;
    }
    
@@ -818,7 +1270,6 @@ void pSolver::solveMultiThreaded(int h, int t, pSolver *data[]){
    }
 
    while(true){
-     cpt++;
 
      if(rstart){
 
@@ -826,43 +1277,46 @@ void pSolver::solveMultiThreaded(int h, int t, pSolver *data[]){
 
        int s = getbpick(data);
 
-       if( data[s]->createJobs(h)){
-	 mpz_set_si(ret, 1);
-	 sharedJob->putResult(ret);
+       //The cubes extend the user assumptions
+       user_assumps.copyTo(data[s]->assumptions);
+       if (data[s]->playAssumptions() == l_False){
+	 data[s]->failAssumptions();
+	 break;
+       }
+
+       //The first jobs are spread over all the deques
+       if( data[s]->createJobs(data[s]->decisionLevel()+h, 0)){
+	 data[s]->storeModel();
 	 break;
        }
        else{
-	 sharedJob->IFinish();
-	 
-	 for (int i=1; i<t; i++)
-	   sharedJob->tids[i-1] =  create_worker(data[i]);
+	 runPhase(cmd_jobs);
        }
        rstart=false;
+       //No global restart when counting: the cubes must be counted once
+       deadline = counting ? 0 : realTime() + rest_base * restart_tick;
      }
     
-     usleep(5000);
-     sharedJob->getResult(ret);
+     sharedJob->waitEvent(seen, deadline);
        
-     if (stop(ret)){
+     if (stop()){
        
-       for (int i=1; i<nbworkers; i++){
-	 pthread_cancel(sharedJob->tids[i-1]);
-	 pthread_join(sharedJob->tids[i-1], NULL);
-       }
+       stopWorkers(data);
        break;
      }
 
-    if(rest_base == cpt){
+    if(deadline && realTime() >= deadline){
       if (verbosity >= 1){
 	 printf("c =========================================================================================================\n");
 	 printf("c |                                          Global Restart : %6d                                      |\n",curr_restarts+1); 
 	 printf("c =========================================================================================================\n");
        }
        
-       for (int i=1; i<nbworkers; i++){
-	 pthread_cancel(sharedJob->tids[i-1]);
-	 pthread_join(sharedJob->tids[i-1], NULL); 
-       }
+       stopWorkers(data);
+
+       //A result posted while the workers were stopped
+       if (stop())
+	 break;
        
        rstart=true;
        rest_base =  pow(2, ++curr_restarts)*restart_base; 
@@ -870,16 +1324,204 @@ void pSolver::solveMultiThreaded(int h, int t, pSolver *data[]){
     
    }
 
+  leavePool();
+
   if (verbosity >= 1)
     printf("c =========================================================================================================\n");
-  
-  mpz_clear(ret);
+}
+
+
+//Share a learnt clause under the current thresholds
+void pSolver::exportLearnt(vec<Lit>& learnt, int nblevels) {
+  if (share_lits && (++share_calls & 255) == 0)
+    adaptSharing();
+  if ((unsigned)nblevels > maxsizeshared || (unsigned)learnt.size() > maxlenshared)
+    return;
+  sharedBase->push(learnt, nblevels, this);
+  exported++;
+  exported_lits += learnt.size();
+  if (import_filter >= 1) filterSeen(hashLits(learnt));
+}
+
+void pSolver::importUsed(int source) {
+  sharedBase->used(source);
+}
+
+//Once per second of cpu time, the thresholds are loosened when fewer
+//literals than targeted were exported, and tightened when more were,
+//or when less than 1% of the exported clauses were used by the others.
+void pSolver::adaptSharing() {
+  double now = cpuThreadTime();
+  if (share_time == 0) share_time = now;
+  if (now - share_time < 1)
+    return;
+
+  double rate = exported_lits / (now - share_time);
+  int used = sharedBase->getUsed(id);
+  bool useless = exported >= 100 && (uint64_t)(used - share_used) * 100 < exported;
+  if (rate < share_lits && !useless){
+    if (maxsizeshared < 30) maxsizeshared++;
+    if (maxlenshared < 1024) maxlenshared += maxlenshared/4;
+  } else if (rate > share_lits || useless){
+    if (maxsizeshared > minsizeshared) maxsizeshared--;
+    maxlenshared -= maxlenshared/4;
+    if (maxlenshared < 8) maxlenshared = 8;
+  }
+
+  share_time = now;
+  share_used = used;
+  exported = exported_lits = 0;
+}
+
+//Whether 'h' was already seen; it is recorded otherwise, the
+//oldest hash of its slots being evicted when both are used
+bool pSolver::filterSeen(uint64_t h) {
+  if (filter.size() == 0) filter.growTo(filter_size, 0);
+  uint32_t i1 = h & (filter_size - 1), i2 = (h >> 32) & (filter_size - 1);
+  if (filter[i1] == h || filter[i2] == h)
+    return true;
+  if (filter[i1] != 0)
+    filter[i2] = filter[i1];
+  filter[i1] = h;
+  return false;
+}
+
+//Whether a binary clause of this solver contains two literals of 'ps'
+bool pSolver::subsumedByBin(const vec<Lit>& ps) {
+  bool sub = false;
+  import_mark.growTo(2*nVars(), 0);
+  for (int i=0; i<ps.size(); i++)
+    import_mark[toInt(ps[i])] = 1;
+  for (int i=0; i<ps.size() && !sub; i++) {
+    vec<Lit>& imps = implied[~ps[i]];
+    for (int k=0; k<imps.size(); k++)
+      if (import_mark[toInt(imps[k])]) {
+	sub = true;
+	break;
+      }
+  }
+  for (int i=0; i<ps.size(); i++)
+    import_mark[toInt(ps[i])] = 0;
+  return sub;
+}
+
+
+//The clauses of the batch are allocated at once, their watchers
+//are pushed list by list, and activities decay once per batch
+//rather than once per clause.
+void pSolver::importLearnts(const uint32_t *recs, int nwords) {
+  if (nwords == 0) return;
+
+  int nclauses = 0, nlits = 0;
+  for (int k=0; k<nwords; k+=3+recs[k+2])
+    if (recs[k+2] > 1){
+      nclauses++;
+      nlits += recs[k+2];
+    }
+  ca.reserve(nclauses, nlits, true);
+  learnts.capacity(learnts.size() + nclauses);
+  frozen_clauses.capacity(frozen_clauses.size() + nclauses);
+
+  import_watches.clear();
+  for (int k=0; k<nwords; k+=3+recs[k+2]) {
+    int nbl = recs[k+1], size = recs[k+2];
+    const uint32_t *lits = recs+k+3;
+
+    if (size == 1){
+      Lit p = toLit(lits[0]);
+      if (value(p) == l_Undef)
+	uncheckedEnqueue(p);
+      continue;
+    }
+
+    import_lits.clear();
+    for (int i=0; i<size; i++)
+      import_lits.push(toLit(lits[i]));
+
+    nbimported++;
+    if (import_filter >= 1 && filterSeen(hashLits(import_lits))){
+      nbdup++;
+      continue;
+    }
+    if (import_filter >= 2){
+      bool sat = false;
+      for (int i=0; i<size && !sat; i++)
+	sat = value(import_lits[i]) == l_True && level(var(import_lits[i])) == 0;
+      if (sat){
+	nbsat++;
+	continue;
+      }
+      if (subsumedByBin(import_lits)){
+	nbsub++;
+	continue;
+      }
+    }
+    //Whatever the filter, a binary clause is only attached once
+    if (size == 2 && hasBinary(import_lits[0], import_lits[1])){
+      nbdup++;
+      continue;
+    }
+
+    CRef cr = ca.alloc(import_lits, true);
+    Clause& c = ca[cr];
+    c.setLBD(nbl);
+    c.setSource(recs[k] + 1);
+    learnts.push(cr);
+    learnts_literals += size;
+    claBumpActivity(c);
+
+    Freeze_params fp = mkFreeze(0, false);
+    fp.freeze = to_freeze(cr);
+    frozen_clauses.push(fp);
+
+    if (size == 2){
+      //Attached right away, for the next binaries of the batch to find it
+      implied[~c[0]].push(c[1]);
+      implied[~c[1]].push(c[0]);
+    }else if (size == 3){
+      import_watches.push(ImportWatch(4*toInt(~c[0]) + 2, TerWatcher(cr, c[1], c[2])));
+      import_watches.push(ImportWatch(4*toInt(~c[1]) + 2, TerWatcher(cr, c[0], c[2])));
+      import_watches.push(ImportWatch(4*toInt(~c[2]) + 2, TerWatcher(cr, c[0], c[1])));
+    }else{
+      import_watches.push(ImportWatch(4*toInt(~c[0]), TerWatcher(cr, c[1], lit_Undef)));
+      import_watches.push(ImportWatch(4*toInt(~c[1]), TerWatcher(cr, c[0], lit_Undef)));
+    }
+  }
+
+  sort(import_watches);
+  for (int i=0, j; i<import_watches.size(); i=j) {
+    uint32_t list = import_watches[i].list;
+    for (j=i; j<import_watches.size() && import_watches[j].list == list; j++);
+    Lit p = toLit(list >> 2);
+    if (list & 2){
+      vec<TerWatcher>& wt = watchesTer[p];
+      wt.capacity(wt.size() + j - i);
+      for (int k=i; k<j; k++)
+	wt.push(import_watches[k].w);
+    }else{
+      vec<Watcher>& ws = watches[p];
+      ws.capacity(ws.size() + j - i);
+      for (int k=i; k<j; k++)
+	ws.push(Watcher(import_watches[k].w.cref, import_watches[k].w.other[0]));
+    }
+  }
+
+  varDecayActivity();
+  claDecayActivity();
 }
 
 
 void  pSolver::printStats() {
-  printf("c Jobs done             : %d \n", nbjobs);
+  printf("c Jobs done             : %d (%d given on request)\n", nbjobs, nbsplits);
+  if (counting)
+    printf("c Cubes counted         : %llu\n", (unsigned long long)nbmodels);
   printf("c CPU Thread time       : %g s\n", thtime);
   printf("c nb Shared learnts     : %d\n", sharedBase->getTotalDB(id));
-  printf("c nb Red. Sh. learnts   : %d\n", sharedBase->getTotalSDB(id));
+  printf("c nb Dropped sh. learnts: %d (missed) %d (too large)\n", sharedBase->getDropped(id), sharedBase->getOversized(id));
+  if (share_lits)
+    printf("c Sharing thresholds    : lbd %u size %u\n", maxsizeshared, maxlenshared);
+  printf("c Import filter hits    : %llu / %llu (%.2f %%) dup %llu sat %llu sub %llu\n",
+	 (unsigned long long)(nbdup+nbsat+nbsub), (unsigned long long)nbimported,
+	 nbimported ? (nbdup+nbsat+nbsub)*100.0/nbimported : 0.0,
+	 (unsigned long long)nbdup, (unsigned long long)nbsat, (unsigned long long)nbsub);
 }
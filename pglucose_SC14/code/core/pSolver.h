@@ -13,7 +13,6 @@ namespace Glucose
 #include "core/SharedBase.h"
 #include <pthread.h>
 #include "mtl/Queue.h"
-#include <gmp.h>
 
 #define MAX_JOBS 1024
 
@@ -27,17 +26,107 @@ namespace Glucose {
     static double const pfstopDB = 0.05;
     static double const pfstopNB = 0.75;
     static double const restart_base = 10000;
+    static double const restart_tick = 0.005;  //seconds per restart_base unit
     static double const distance = 0;
     static pSolver ** solvers;
-    static int folio;
+    static bool pinning;
+    static vec<int> cpu_order;  //allowed cpus, grouped by NUMA node
+    static bool counting;  //#SAT: the workers count the models of their cubes
+
+    //Persistent pool: the workers are created once and wait for
+    //the next command of the pricipal process (see thread_work)
+    enum { cmd_none, cmd_portfolio, cmd_jobs, cmd_quit };
+    static int             pool_cmd;
+    static unsigned int    pool_epoch;  //bumped by every command
+    static unsigned int    pool_base;   //pool_epoch when the pool started
+    static bool            pool_started;
+    static int             pool_busy;   //workers running the command
+    static pthread_mutex_t pool_mutex;
+    static pthread_cond_t  pool_cmd_cond;
+    static pthread_cond_t  pool_done_cond;
+    static int modelset;   //set by the first worker storing its model
     static Queue<Lit> vars;
 
     int          id;
     double       thtime;      
     unsigned int maxsizeshared;
+    bool         shareorig;
     SharedBase   *sharedBase;
     Shared       *sharedJob;
     unsigned int nbjobs;
+    unsigned int nbsplits;    //jobs given to idle workers from search()
+
+    //Watchers of a batch of imported clauses, sorted by
+    //list before being attached (see importLearnts)
+    struct ImportWatch {
+      uint32_t   list;             //4*lit, +2 for watchesTer
+      TerWatcher w;                //only other[0] out of watchesTer
+      ImportWatch() : list(0), w(CRef_Undef, lit_Undef, lit_Undef) {}
+      ImportWatch(uint32_t l, const TerWatcher& w_) : list(l), w(w_) {}
+      bool operator<(const ImportWatch& o) const { return list < o.list; }
+    };
+    vec<Lit>         cube;           //decisions of a job being created
+
+    //Choice of the split literals in createJobs
+    enum { split_vsids, split_lookahead };
+    int              split;
+    int              split_cands;
+    vec<Var>         probe_vars;
+
+    //Incremental use: the pool is kept between the calls to
+    //solveMultiThreaded(), which solve under 'user_assumps'
+    bool             keep_pool;
+    vec<Lit>         user_assumps;
+    void failAssumptions();
+
+    Lit lookaheadLit(bool& forced);
+    void storeModel();
+    void splitCube();
+    void pushCube(int owner);
+
+    //Model counting
+    vec<Lit>         block;          //negation of the decisions of a counted cube
+    vec<vec<Lit> >   count_clauses;  //original and blocking clauses, to satisfy by the cubes (empty once removed)
+    vec<vec<int> >   count_watches;  //per literal, the clauses it satisfies in the last model
+    struct CountBlock { CRef cr; int id; };
+    vec<CountBlock>  count_blocks;   //blocking clauses (and their index in count_clauses), the last one on top
+    vec<char>        count_mark;
+    uint64_t         nbmodels;       //cubes counted
+    uint64_t         job_models;     //nbmodels when the job started
+
+    lbool countModels();
+    bool blockModel();
+    template<class Lits>
+    void addCountClause(const Lits& c);
+    Lit lowestTrue(const vec<Lit>& c) const;
+    //A cube is not split once models of it are blocked: the other
+    //workers would count them again
+    bool canSplit() const { return !counting || nbmodels == job_models; }
+    vec<ImportWatch> import_watches;
+    vec<Lit>         import_lits;
+
+    //Filter of the imported clauses: 0 none, 1 duplicates,
+    //2 also satisfied at level 0 or subsumed by a binary clause
+    int              import_filter;
+    vec<uint64_t>    filter;         //hashes of recent shared clauses, 2 slots each
+    vec<char>        import_mark;
+    uint64_t         nbimported, nbdup, nbsat, nbsub;
+
+    bool filterSeen(uint64_t h);
+    bool subsumedByBin(const vec<Lit>& ps);
+
+    //Sharing thresholds, adapted so that this worker exports about
+    //'share_lits' literals per second of its own cpu time (0: fixed -msh)
+    int              share_lits;
+    unsigned int     maxlenshared, minsizeshared;
+    uint64_t         exported, exported_lits, share_calls;
+    double           share_time;
+    int              share_used;
+
+    void exportLearnt(vec<Lit>& learnt, int nblevels);
+    void adaptSharing();
+    virtual void importUsed(int source);
+    virtual void relocAll(ClauseAllocator& to);
  
     // Create and start a thread
     pthread_t create_worker(void *arg);
@@ -46,6 +135,8 @@ namespace Glucose {
     virtual lbool playAssumptions();
     //Associate a job to a thread 
     static void* bootstrap(void * arg);
+    //Copy the problem of solvers[0] into a worker
+    static void* copy_bootstrap(void * arg);
 
     // The solving algorithems (DPLL based)
     lbool search(int nof_conflicts);
@@ -55,28 +146,55 @@ namespace Glucose {
     //Pricise The work to do by a thread
     virtual  void* thread_work();
     // Create Jobs with respect to a height h
-    virtual bool createJobs(unsigned int);
+    virtual bool createJobs(unsigned int, int owner = -1);
     //Main loop for a thread: pick a subproblem resolve it 
     //and passe to a new one if any.
     virtual void searchSubProblem();    
     bool grestart(pSolver* []);
     int getbpick(pSolver* []);
+    void stopWorkers(pSolver* []);
+    void startPool(pSolver* []);
+    void runPhase(int cmd);
+    void quitPool();
+    void leavePool(){ if (!keep_pool) quitPool(); }
+    static void pinThread(int k);
+    static void orderCpus();
     void getfirstLits();
       
   
   public :
    
     friend class SharedBase;
+    friend class ParallelSolver;
 
     pSolver():
       id(0),
       thtime(0),    
       maxsizeshared(0),
+      shareorig(false),
       sharedBase(0),
       sharedJob(0),
-      nbjobs(0){}
+      nbjobs(0),
+      nbsplits(0),
+      split(split_vsids),
+      split_cands(16),
+      keep_pool(false),
+      nbmodels(0),
+      job_models(0),
+      import_filter(1),
+      nbimported(0), nbdup(0), nbsat(0), nbsub(0),
+      share_lits(0),
+      maxlenshared(INT32_MAX),
+      minsizeshared(0),
+      exported(0), exported_lits(0), share_calls(0),
+      share_time(0),
+      share_used(0){}
     
     virtual void solveMultiThreaded(int h, int t, pSolver *datas[]);
+    //Add a batch of learnts shared by other workers, given
+    //as SharedBase records [producer, nblevels, size, lits]
+    void importLearnts(const uint32_t *recs, int nwords);
+    static  void replicate(int t, pSolver *datas[]);
     void printStats();
 
     double gettime() const {return thtime;}
@@ -84,12 +202,32 @@ namespace Glucose {
     void setId(int id){this->id =id;}
     void setSdb(SharedBase *sb){sharedBase=sb;}
     void setSqueue(Shared *sq){sharedJob=sq;}
-    void setMsshared(int mss){maxsizeshared=mss;}
-    bool stop(mpz_t ret){
-      return (mpz_cmp_si(ret, -1)==0 ||
-	      mpz_cmp_si(ret, -1)<0  ||
-	      mpz_cmp_si(ret, 1)==0  ||
-	      mpz_cmp_si(ret, 1)>0);
+    void setMsshared(int mss){maxsizeshared=mss; setShareBounds();}
+    void setImportFilter(int f){import_filter=f;}
+    void setSplit(int s, int cands){split=s; split_cands=cands;}
+    static void setPinning(bool p){pinning=p;}
+    static void setCounting(bool c){counting=c;}
+    void setKeepPool(bool k){keep_pool=k;}
+    void setAssumptions(const vec<Lit>& assumps){assumps.copyTo(user_assumps);}
+    //Terminate the workers kept by setKeepPool()
+    void releasePool(){ if (pool_started) quitPool(); }
+    void setShareLits(int sl){share_lits=sl; setShareBounds();}
+    //The adapted LBD bound never drops below 2, nor below a smaller -msh
+    void setShareBounds(){
+      minsizeshared = maxsizeshared < 2 ? maxsizeshared : 2;
+      maxlenshared = share_lits ? 8*(maxsizeshared < 1 ? 1 : maxsizeshared) : INT32_MAX;
+    }
+    //The original clauses are shared read-only between
+    //all workers: they are never removed nor reordered.
+    void setShareOrig(bool so){
+      shareorig=so;
+      if(so){
+	remove_satisfied=false;
+	ca.extra_clause_field=true;
+      }
+    }
+    bool stop(){
+      return sharedJob->getResult() != l_Undef;
     }
    
   };
@@ -21,6 +21,8 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #ifndef Glucose_Alloc_h
 #define Glucose_Alloc_h
 
+#include <string.h>
+
 #include "mtl/XAlloc.h"
 #include "mtl/Vec.h"
 
@@ -28,35 +30,57 @@ namespace Glucose {
 
 //=================================================================================================
 // Simple Region-based memory allocator:
+//
+// References are 32-bit offsets, which limits a region to 2^32 elements (16 GB of 'uint32_t').
+// Compiled with '-D CREF64' ("make CREF64=1"), they are 64-bit offsets: the elements themselves
+// do not change, but every structure holding a reference grows (see 'Solver::Watcher').
+//
+// A user of the references may keep some of their values for itself, with a lower 'limit()' on
+// the capacity (see 'CRef_BinConflict'). Growing beyond the limit throws 'OutOfMemoryException',
+// as when the memory itself (e.g. '-mem-lim') is exhausted.
+
+#ifdef CREF64
+typedef uint64_t RegionRef;
+#else
+typedef uint32_t RegionRef;
+#endif
 
 template<class T>
 class RegionAllocator
 {
-    T*        memory;
-    uint32_t  sz;
-    uint32_t  cap;
-    uint32_t  wasted_;
-
-    void capacity(uint32_t min_cap);
-
  public:
     // TODO: make this a class for better type-checking?
-    typedef uint32_t Ref;
-    enum { Ref_Undef = UINT32_MAX };
+    typedef RegionRef Ref;
+    static const Ref Ref_Undef = ~(Ref)0;
     enum { Unit_Size = sizeof(uint32_t) };
 
-    explicit RegionAllocator(uint32_t start_cap = 1024*1024) : memory(NULL), sz(0), cap(0), wasted_(0){ capacity(start_cap); }
+ private:
+    T*        memory;
+    Ref       sz;
+    Ref       cap;
+    Ref       wasted_;
+    Ref       lim;        // Largest capacity (the references stay below it).
+    bool      owned;      // False while 'memory' is a region given to 'adopt()'.
+
+    void capacity(Ref min_cap);
+
+ protected:
+    void     limit     (Ref max_cap) { assert(sz <= max_cap); lim = max_cap; if (cap > lim) cap = lim; }
+
+ public:
+    explicit RegionAllocator(Ref start_cap = 1024*1024) : memory(NULL), sz(0), cap(0), wasted_(0), lim(Ref_Undef), owned(true){ capacity(start_cap); }
     ~RegionAllocator()
     {
-        if (memory != NULL)
+        if (memory != NULL && owned)
             ::free(memory);
     }
 
 
-    uint32_t size      () const      { return sz; }
-    uint32_t wasted    () const      { return wasted_; }
+    Ref      size      () const      { return sz; }
+    Ref      wasted    () const      { return wasted_; }
 
     Ref      alloc     (int size); 
+    void     reserve   (Ref size)    { capacity(sz + size); }
     void     free      (int size)    { wasted_ += size; }
 
     // Deref, Load Effective Address (LEA), Inverse of LEA (AEL):
@@ -69,40 +93,71 @@ class RegionAllocator
         return  (Ref)(t - &memory[0]); }
 
     void     moveTo(RegionAllocator& to) {
-        if (to.memory != NULL) ::free(to.memory);
+        if (to.memory != NULL && to.owned) ::free(to.memory);
         to.memory = memory;
         to.sz = sz;
         to.cap = cap;
         to.wasted_ = wasted_;
+        to.lim = lim;
+        to.owned = owned;
 
         memory = NULL;
         sz = cap = wasted_ = 0;
     }
 
+    // Bulk copy of the whole region (references stay valid in 'to'):
+    void     copyTo(RegionAllocator& to) const {
+        to.sz = 0;
+        to.capacity(sz);
+        memcpy(to.memory, memory, sizeof(T)*sz);
+        to.sz = sz;
+        to.wasted_ = wasted_;
+    }
+
+    // Use the 'size' elements at 'mem' (e.g. a mapped file) as the region, without copying them.
+    // 'mem' is not freed here and must outlive the allocator, or at least its first growth, where
+    // the region is copied to owned memory.
+    void     adopt(T* mem, Ref size) {
+        if (memory != NULL && owned) ::free(memory);
+        memory = mem;
+        sz = cap = size;
+        wasted_ = 0;
+        owned = false;
+    }
 
 };
 
 template<class T>
-void RegionAllocator<T>::capacity(uint32_t min_cap)
+void RegionAllocator<T>::capacity(Ref min_cap)
 {
     if (cap >= min_cap) return;
 
-    uint32_t prev_cap = cap;
+    Ref prev_cap = cap;
     while (cap < min_cap){
         // NOTE: Multiply by a factor (13/8) without causing overflow, then add 2 and make the
         // result even by clearing the least significant bit. The resulting sequence of capacities
         // is carefully chosen to hit a maximum capacity that is close to the '2^32-1' limit when
         // using 'uint32_t' as indices so that as much as possible of this space can be used.
-        uint32_t delta = ((cap >> 1) + (cap >> 3) + 2) & ~1;
+        Ref delta = ((cap >> 1) + (cap >> 3) + 2) & ~(Ref)1;
         cap += delta;
 
         if (cap <= prev_cap)
             throw OutOfMemoryException();
     }
+    if (cap > lim){
+        if (min_cap > lim)
+            throw OutOfMemoryException();
+        cap = lim; }
     //printf(" .. (%p) cap = %u\n", this, cap);
 
     assert(cap > 0);
-    memory = (T*)xrealloc(memory, sizeof(T)*cap);
+    if (owned)
+        memory = (T*)xrealloc(memory, sizeof(T)*cap);
+    else{
+        T* mem = (T*)xrealloc(NULL, sizeof(T)*cap);
+        if (sz > 0) memcpy(mem, memory, sizeof(T)*sz);
+        memory = mem;
+        owned  = true; }
 }
 
 
@@ -114,7 +169,7 @@ RegionAllocator<T>::alloc(int size)
     assert(size > 0);
     capacity(sz + size);
 
-    uint32_t prev_sz = sz;
+    Ref prev_sz = sz;
     sz += size;
     
     // Handle overflow:
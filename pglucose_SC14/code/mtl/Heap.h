@@ -139,6 +139,13 @@ class Heap {
             indices[heap[i]] = -1;
         heap.clear(dealloc); 
     }
+
+    // Copy the heap layout (the comparator of 'copy' is kept):
+    void copyTo(Heap& copy) const
+    {
+        heap   .copyTo(copy.heap);
+        indices.copyTo(copy.indices);
+    }
 };
 
 
@@ -27,6 +27,11 @@ COPTIMIZE ?= -O3
 CFLAGS    += -I$(MROOT) -D __STDC_LIMIT_MACROS -D __STDC_FORMAT_MACROS -lpthread
 LFLAGS    += -lz
 
+## "make CREF64=1" for 64-bit clause references (clause arenas above 16 GB, see mtl/Alloc.h); run "make clean" first
+ifdef CREF64
+CFLAGS    += -D CREF64
+endif
+
 .PHONY : s p d r rs clean 
 
 s:	$(EXEC)
@@ -0,0 +1,148 @@
+/*************************************************************************************[test/Main.cc]
+Test of the incremental interface of 'ParallelSolver': clauses and assumptions are added between
+the calls to 'solve()', and each answer is checked against a sequential 'Solver' given the same
+clauses. The models must satisfy all the clauses and the assumptions; the final conflicts must
+be made of negated assumptions that are indeed inconsistent with the clauses.
+
+  USAGE: inctest [-workers=N] [-vars=N] [-steps=N] [-seed=N]
+  Prints "OK" and exits with 0 when every answer is right.
+**************************************************************************************************/
+
+#include "utils/Options.h"
+#include "core/ParallelSolver.h"
+
+using namespace Glucose;
+
+//=================================================================================================
+
+
+static IntOption opt_workers("TEST", "workers", "Number of workers",                  3,   IntRange(1, 64));
+static IntOption opt_vars   ("TEST", "vars",    "Variables of the random problems",   80,  IntRange(10, INT32_MAX));
+static IntOption opt_steps  ("TEST", "steps",   "Calls to 'solve()' per random problem", 25, IntRange(1, INT32_MAX));
+static IntOption opt_seed   ("TEST", "seed",    "Seed of the random problems",        1,   IntRange(1, INT32_MAX));
+
+static int failures = 0;
+
+// (the generator of 'Solver')
+static double drand(double& seed) {
+    seed *= 1389796;
+    int q = (int)(seed / 2147483647);
+    seed -= (double)q * 2147483647;
+    return seed / 2147483647; }
+static int irand(double& seed, int size) { return (int)(drand(seed) * size); }
+
+static void check(bool cond, const char* what, int step){
+    if (!cond){
+        printf("FAILED at step %d: %s\n", step, what);
+        failures++; }
+}
+
+
+// Both solvers get the same clauses:
+struct Pair {
+    ParallelSolver    P;
+    Solver            R;
+    vec<vec<Lit> >    clauses;
+
+    Pair(int workers) : P(workers) {}
+
+    void newVars(int n){ for (int i = 0; i < n; i++) P.newVar(), R.newVar(); }
+    void add(const vec<Lit>& c){
+        clauses.push(); c.copyTo(clauses.last());
+        P.addClause(c);
+        R.addClause(c); }
+    void add(Lit a, Lit b)       { vec<Lit> c; c.push(a); c.push(b); add(c); }
+    void add(Lit a, Lit b, Lit d){ vec<Lit> c; c.push(a); c.push(b); c.push(d); add(c); }
+
+    // Solves under 'as' with both solvers, checks the answer of 'P', and returns it:
+    bool solve(const vec<Lit>& as, int step){
+        bool res = P.solve(as);
+        check(res == R.solve(as), "different answers", step);
+        if (res){
+            for (int i = 0; i < clauses.size(); i++){
+                bool sat = false;
+                for (int j = 0; j < clauses[i].size(); j++)
+                    sat |= P.model[var(clauses[i][j])] == (sign(clauses[i][j]) ? l_False : l_True);
+                check(sat, "model falsifies a clause", step); }
+            for (int j = 0; j < as.size(); j++)
+                check(P.model[var(as[j])] == (sign(as[j]) ? l_False : l_True), "model falsifies an assumption", step);
+        }else{
+            vec<Lit> core;
+            for (int j = 0; j < P.conflict.size(); j++){
+                bool in = false;
+                for (int k = 0; k < as.size(); k++) in |= as[k] == ~P.conflict[j];
+                check(in, "conflict literal is not a negated assumption", step);
+                core.push(~P.conflict[j]); }
+            check(!R.solve(core), "conflict is consistent with the clauses", step);
+            check(P.okay() == (P.conflict.size() > 0), "okay() does not match the conflict", step);
+        }
+        return res;
+    }
+};
+
+
+// add -> solve -> add -> solve, on a chain of implications x0 -> x1 -> ... -> x9:
+static void chain(int workers)
+{
+    Pair     S(workers);
+    vec<Lit> as;
+    S.newVars(10);
+    for (int i = 0; i < 9; i++)
+        S.add(~mkLit(i), mkLit(i+1));
+    as.push(mkLit(0));
+    check(S.solve(as, 1), "x0 is consistent", 1);
+
+    as.push(~mkLit(9));
+    check(!S.solve(as, 2), "x0 & ~x9 is inconsistent", 2);
+    check(S.P.okay(), "the clauses alone are consistent", 2);
+
+    vec<Lit> none;
+    S.add(~mkLit(5), mkLit(5), ~mkLit(9));   // (tautology, ignored)
+    S.add(~mkLit(9), ~mkLit(0));
+    check(S.solve(none, 3), "x0 may be false", 3);
+    as.clear(); as.push(mkLit(0));
+    check(!S.solve(as, 4), "x0 is now inconsistent", 4);
+
+    vec<Lit> unit; unit.push(mkLit(0));
+    S.add(unit);
+    check(!S.solve(none, 5), "the clauses are inconsistent", 5);
+    check(!S.P.okay(), "inconsistent for good", 5);
+}
+
+
+// Random 3-SAT, growing towards the threshold, under random assumptions:
+static void randomSteps(int workers, int nvars, int steps, double seed)
+{
+    Pair S(workers);
+    S.newVars(nvars);
+    for (int step = 0; step < steps && S.P.okay(); step++){
+        for (int k = 0; k < (int)(nvars * 4.3 / steps); k++){
+            vec<Lit> c;
+            while (c.size() < 3){
+                Lit  p   = mkLit(irand(seed, nvars), drand(seed) < 0.5);
+                bool dup = false;
+                for (int j = 0; j < c.size(); j++) dup |= var(c[j]) == var(p);
+                if (!dup) c.push(p); }
+            S.add(c); }
+        vec<Lit> as;
+        for (int k = irand(seed, 7); k > 0; k--){
+            Lit  p   = mkLit(irand(seed, nvars), drand(seed) < 0.5);
+            bool dup = false;
+            for (int j = 0; j < as.size(); j++) dup |= var(as[j]) == var(p);
+            if (!dup) as.push(p); }
+        S.solve(as, 100 + step);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    setUsageHelp("USAGE: %s [options]\n");
+    parseOptions(argc, argv, true);
+
+    chain(opt_workers);
+    randomSteps(opt_workers, opt_vars, opt_steps, opt_seed);
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
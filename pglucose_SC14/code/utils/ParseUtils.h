@@ -24,42 +24,116 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #include <zlib.h>
 
 namespace Glucose {
 
 //-------------------------------------------------------------------------------------------------
-// A simple buffered character stream class:
+// A simple buffered character stream class. Decompression runs on a separate thread which fills
+// one buffer while the other one is being tokenized. The buffers are on the heap, as the stream
+// usually lives on the stack of the parser:
 
 static const int buffer_size = 1048576;
 
 
 class StreamBuffer {
-    gzFile        in;
-    unsigned char buf[buffer_size];
-    int           pos;
-    int           size;
+    gzFile          in;
+    unsigned char*  bufs[2];
+    int             sizes[2];
+    bool            full[2];
+    bool            stop;
+    int             cur;
+    int             pos;
+    int             size;
+    bool            eof;
+    pthread_t       reader;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+
+    static void* readLoop(void* arg) {
+        StreamBuffer& sb = *(StreamBuffer*)arg;
+        for (int i = 0;; i ^= 1){
+            pthread_mutex_lock(&sb.mutex);
+            while (sb.full[i] && !sb.stop) pthread_cond_wait(&sb.cond, &sb.mutex);
+            pthread_mutex_unlock(&sb.mutex);
+            if (sb.stop) break;
+
+            int n = gzread(sb.in, sb.bufs[i], buffer_size);
+
+            pthread_mutex_lock(&sb.mutex);
+            sb.sizes[i] = n;
+            sb.full[i]  = true;
+            pthread_cond_signal(&sb.cond);
+            pthread_mutex_unlock(&sb.mutex);
+            if (n <= 0) break; }
+        return NULL; }
 
     void assureLookahead() {
-        if (pos >= size) {
+        if (pos >= size && !eof) {
+            pthread_mutex_lock(&mutex);
+            if (cur >= 0) { full[cur] = false; pthread_cond_signal(&cond); }
+            cur = (cur + 1) & 1;
+            while (!full[cur]) pthread_cond_wait(&cond, &mutex);
+            pthread_mutex_unlock(&mutex);
             pos  = 0;
-            size = gzread(in, buf, sizeof(buf)); } }
+            size = sizes[cur];
+            eof  = size <= 0; } }
 
 public:
-    explicit StreamBuffer(gzFile i) : in(i), pos(0), size(0) { assureLookahead(); }
-
-    int  operator *  () const { return (pos >= size) ? EOF : buf[pos]; }
+    explicit StreamBuffer(gzFile i) : in(i), stop(false), cur(-1), pos(0), size(0), eof(false) {
+        bufs[0] = new unsigned char[2 * buffer_size];
+        bufs[1] = bufs[0] + buffer_size;
+        full[0] = full[1] = false;
+        pthread_mutex_init(&mutex, NULL);
+        pthread_cond_init(&cond, NULL);
+        pthread_create(&reader, NULL, readLoop, this);
+        assureLookahead(); }
+
+    ~StreamBuffer() {
+        pthread_mutex_lock(&mutex);
+        stop = true;
+        pthread_cond_signal(&cond);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(reader, NULL);
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&mutex);
+        delete[] bufs[0]; }
+
+    int  operator *  () const { return (pos >= size) ? EOF : bufs[cur][pos]; }
     void operator ++ ()       { pos++; assureLookahead(); }
     int  position    () const { return pos; }
 };
 
 
 //-------------------------------------------------------------------------------------------------
-// End-of-file detection functions for StreamBuffer and char*:
+// A character stream over a memory range (e.g. a chunk of a mmapped file):
+
+
+class MemBuffer {
+    const char* ptr;
+    const char* end;
+
+public:
+    MemBuffer(const char* b, const char* e) : ptr(b), end(e) {}
+
+    int         operator *  () const { return (ptr >= end) ? EOF : (unsigned char)*ptr; }
+    void        operator ++ ()       { ptr++; }
+    const char* position    () const { return ptr; }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// End-of-file detection functions for StreamBuffer, MemBuffer and char*:
 
 
 static inline bool isEof(StreamBuffer& in) { return *in == EOF;  }
+static inline bool isEof(MemBuffer&    in) { return *in == EOF;  }
 static inline bool isEof(const char*   in) { return *in == '\0'; }
 
 //-------------------------------------------------------------------------------------------------
@@ -145,6 +219,101 @@ static bool eagerMatch(B& in, const char* str) {
     return true; }
 
 
+//-------------------------------------------------------------------------------------------------
+// Block scanners for in-memory input: 'spaces', 'digits' and 'minus' return the bit masks of the
+// whitespace, digit and '-' bytes among the 'width' bytes starting at 'p'. The scan functions below are
+// instantiated for each of them; 'simdLevel()' tells which ones the running CPU supports.
+
+
+enum { simd_none = 0, simd_sse2 = 1, simd_avx2 = 2 };
+
+static inline int simdLevel() {
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("avx2") ? simd_avx2 : simd_sse2;
+#else
+    return simd_none;
+#endif
+}
+
+struct ScalarScan {
+    enum { width = 1 };
+    static inline unsigned full  ()              { return 1; }
+    static inline unsigned spaces(const char* p) { return (*p >= 9 && *p <= 13) || *p == 32; }
+    static inline unsigned digits(const char* p) { return *p >= '0' && *p <= '9'; }
+    static inline unsigned minus (const char* p) { return *p == '-'; }
+};
+
+#if defined(__x86_64__)
+struct SSE2Scan {
+    enum { width = 16 };
+    static inline unsigned full  ()              { return 0xFFFF; }
+    static inline unsigned spaces(const char* p) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                              _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(8)),
+                                                            _mm_cmplt_epi8(v, _mm_set1_epi8(14))))); }
+    static inline unsigned digits(const char* p) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        return _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0'-1)),
+                                               _mm_cmplt_epi8(v, _mm_set1_epi8('9'+1)))); }
+    static inline unsigned minus (const char* p) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8('-'))); }
+};
+
+// Everything instantiated with AVX2Scan must be compiled for this target too, see 'Dimacs.h'.
+#pragma GCC push_options
+#pragma GCC target("avx2")
+struct AVX2Scan {
+    enum { width = 32 };
+    static inline unsigned full  ()              { return 0xFFFFFFFF; }
+    static inline unsigned spaces(const char* p) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        return _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                    _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(8)),
+                                                                     _mm256_cmpgt_epi8(_mm256_set1_epi8(14), v)))); }
+    static inline unsigned digits(const char* p) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        return _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0'-1)),
+                                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9'+1), v))); }
+    static inline unsigned minus (const char* p) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), _mm256_set1_epi8('-'))); }
+};
+#pragma GCC pop_options
+#endif
+
+
+// Returns the first non-whitespace position of [p, end).
+template<class Scan>
+static inline const char* scanWhitespace(const char* p, const char* end) {
+    for (; p + Scan::width <= end; p += Scan::width){
+        unsigned m = ~Scan::spaces(p) & Scan::full();
+        if (m) return p + __builtin_ctz(m); }
+    while (p < end && ((*p >= 9 && *p <= 13) || *p == 32)) p++;
+    return p; }
+
+// Returns the end of the digit run starting at 'p'.
+template<class Scan>
+static inline const char* scanDigits(const char* p, const char* end) {
+    for (; p + Scan::width <= end; p += Scan::width){
+        unsigned m = ~Scan::digits(p) & Scan::full();
+        if (m) return p + __builtin_ctz(m); }
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    return p; }
+
+// Same as 'parseInt()', without skipping leading whitespace. 'p' is advanced past the integer.
+template<class Scan>
+static inline int scanInt(const char*& p, const char* end) {
+    bool neg = false;
+    if      (p < end && *p == '-') neg = true, p++;
+    else if (p < end && *p == '+') p++;
+    const char* q = scanDigits<Scan>(p, end);
+    if (q == p) fprintf(stderr, "PARSE ERROR! Unexpected char: %c\n", p < end ? *p : ' '), exit(3);
+    int val = 0;
+    for (; p < q; p++)
+        val = val*10 + (*p - '0');
+    return neg ? -val : val; }
+
+
 //=================================================================================================
 }
 
@@ -32,6 +32,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 namespace Glucose {
 
 static inline double cpuThreadTime(void);
+static inline double realTime(void); // Wall-clock time in seconds.
 static inline double cpuTime(void); // CPU-time in seconds.
 extern double memUsed();            // Memory in mega bytes (returns 0 for unsupported architectures).
 extern double memUsedPeak();        // Peak-memory in mega bytes (returns 0 for unsupported architectures).
@@ -57,6 +58,11 @@ static inline double Glucose::cpuThreadTime(void){
   return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1000000;
 }
 
+static inline double Glucose::realTime(void) {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000; }
+
 static inline double Glucose::cpuTime(void) {
     struct rusage ru;
     getrusage(RUSAGE_SELF, &ru);